@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <do_ast/arena_allocator.h>
+
+namespace do_ast {
+
+    template<class T, std::size_t TAlignment = 64, class TUpstream = std::allocator<char>>
+    struct AlignedAllocator
+    {
+        // allocator for simd kernels over whole containers, memory comes from TUpstream.
+        // every allocation starts on a TAlignment boundary. it is padded to a multiple of TAlignment
+        // and then extended by one more TAlignment block, so a kernel may read and write whole
+        // TAlignment sized vectors starting at any element without a scalar epilogue.
+        // the padding is zeroed when allocated, afterwards its contents are unspecified.
+
+        static_assert((TAlignment & (TAlignment - 1)) == 0, "TAlignment must be a power of two.");
+        static_assert(TAlignment >= alignof(T), "TAlignment must satisfy the alignment of T.");
+
+        using value_type = T;
+        using Alignment = std::integral_constant<std::size_t, TAlignment>;
+        using upstream_type = rebind_alloc_t<TUpstream, char>;
+        using propagate_on_container_copy_assignment = typename std::allocator_traits<upstream_type>::propagate_on_container_copy_assignment;
+        using propagate_on_container_move_assignment = typename std::allocator_traits<upstream_type>::propagate_on_container_move_assignment;
+        using propagate_on_container_swap = typename std::allocator_traits<upstream_type>::propagate_on_container_swap;
+
+        template<class U> struct rebind { using other = AlignedAllocator<U, TAlignment, TUpstream>; };
+
+        AlignedAllocator() = default;
+        AlignedAllocator(const TUpstream& upstream) : m_upstream(upstream) {}
+        template<class U> AlignedAllocator(const AlignedAllocator<U, TAlignment, TUpstream>& other) : m_upstream(other.upstream()) {}
+
+        // bytes usable by a kernel for n items, including the padding
+        static std::size_t padded_bytes(std::size_t n)
+        {
+            return ((n * sizeof(T) + TAlignment - 1) & ~(TAlignment - 1)) + TAlignment;
+        }
+
+        T* allocate(std::size_t n)
+        {
+            // the original pointer is stored in front of the aligned block for deallocate
+            auto num_bytes = padded_bytes(n);
+            char* raw = m_upstream.allocate(raw_bytes(n));
+            auto address = reinterpret_cast<std::uintptr_t>(raw + sizeof(char*));
+            char* aligned = reinterpret_cast<char*>((address + TAlignment - 1) & ~(std::uintptr_t(TAlignment) - 1));
+            std::memcpy(aligned - sizeof(char*), &raw, sizeof(char*));
+            std::memset(aligned + n * sizeof(T), 0, num_bytes - n * sizeof(T));
+            return reinterpret_cast<T*>(aligned);
+        }
+
+        void deallocate(T* ptr, std::size_t n)
+        {
+            char* raw;
+            std::memcpy(&raw, reinterpret_cast<char*>(ptr) - sizeof(char*), sizeof(char*));
+            m_upstream.deallocate(raw, raw_bytes(n));
+        }
+
+        const upstream_type& upstream() const { return m_upstream; }
+
+        template<class U> bool operator==(const AlignedAllocator<U, TAlignment, TUpstream>& other) const { return m_upstream == other.upstream(); }
+        template<class U> bool operator!=(const AlignedAllocator<U, TAlignment, TUpstream>& other) const { return m_upstream != other.upstream(); }
+
+    protected:
+        static std::size_t raw_bytes(std::size_t n) { return padded_bytes(n) + TAlignment - 1 + sizeof(char*); }
+
+        upstream_type m_upstream;
+    };
+
+} // namespace do_ast
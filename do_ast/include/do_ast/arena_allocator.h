@@ -0,0 +1,128 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+#include <type_traits>
+#include <algorithm>
+
+namespace do_ast {
+
+    template<class TAllocator, class T>
+    using rebind_alloc_t = typename std::allocator_traits<TAllocator>::template rebind_alloc<T>;
+
+    struct MonotonicArena
+    {
+        // bump allocator over a list of chunks.
+        // deallocation is a no-op, all memory is returned at once by release() or the destructor.
+        // containers growing inside the arena leave their old buffers behind, reserve when the size is known.
+
+        explicit MonotonicArena(std::size_t chunk_size = std::size_t(1) << 20)
+        : m_chunk_size(chunk_size)
+        {}
+        ~MonotonicArena() { release(); }
+
+        MonotonicArena(const MonotonicArena&) = delete;
+        MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+        void* allocate(std::size_t size, std::size_t alignment)
+        {
+            auto aligned = align_up(m_cursor, alignment);
+            if ((m_cursor == nullptr) || (aligned > m_end) || (size > static_cast<std::size_t>(m_end - aligned)))
+            {
+                add_chunk(size + alignment);
+                aligned = align_up(m_cursor, alignment);
+            }
+            m_cursor = aligned + size;
+            m_bytes_used += size;
+            return aligned;
+        }
+
+        // frees all chunks, everything allocated from the arena becomes invalid
+        void release()
+        {
+            while (m_chunks != nullptr)
+            {
+                Chunk* prev = m_chunks->prev;
+                std::free(m_chunks);
+                m_chunks = prev;
+            }
+            m_cursor = nullptr;
+            m_end = nullptr;
+            m_bytes_used = 0;
+            m_bytes_reserved = 0;
+        }
+
+        std::size_t bytes_used() const { return m_bytes_used; }
+        std::size_t bytes_reserved() const { return m_bytes_reserved; }
+
+    protected:
+        struct Chunk
+        {
+            Chunk* prev;
+            std::size_t size;
+        };
+
+        static char* align_up(char* ptr, std::size_t alignment)
+        {
+            auto address = reinterpret_cast<std::uintptr_t>(ptr);
+            return reinterpret_cast<char*>((address + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+        }
+
+        void add_chunk(std::size_t min_size)
+        {
+            // chunks grow geometrically, oversized requests get a chunk of their own size
+            auto size = std::max(min_size + sizeof(Chunk), m_chunk_size);
+            m_chunk_size = std::max(m_chunk_size, std::min(m_chunk_size * 2, MaxChunkSize::value));
+            auto* chunk = static_cast<Chunk*>(std::malloc(size));
+            if (chunk == nullptr) throw std::bad_alloc();
+            chunk->prev = m_chunks;
+            chunk->size = size;
+            m_chunks = chunk;
+            m_cursor = reinterpret_cast<char*>(chunk) + sizeof(Chunk);
+            m_end = reinterpret_cast<char*>(chunk) + size;
+            m_bytes_reserved += size;
+        }
+
+        using MaxChunkSize = std::integral_constant<std::size_t, std::size_t(64) << 20>;
+
+        Chunk* m_chunks = nullptr;
+        char* m_cursor = nullptr;
+        char* m_end = nullptr;
+        std::size_t m_chunk_size;
+        std::size_t m_bytes_used = 0;
+        std::size_t m_bytes_reserved = 0;
+    };
+
+    template<class T>
+    struct ArenaAllocator
+    {
+        // std allocator drawing from a MonotonicArena, deallocate does nothing.
+        // copies and rebinds share the arena.
+
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        explicit ArenaAllocator(MonotonicArena& arena) noexcept : m_arena(&arena) {}
+        template<class U> ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.arena()) {}
+
+        T* allocate(std::size_t n)
+        {
+            return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        void deallocate(T*, std::size_t) noexcept {}
+
+        MonotonicArena* arena() const { return m_arena; }
+
+        template<class U> bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.arena(); }
+        template<class U> bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.arena(); }
+
+    protected:
+        MonotonicArena* m_arena;
+    };
+
+} // namespace do_ast
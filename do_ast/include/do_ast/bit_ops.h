@@ -0,0 +1,45 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace do_ast {
+
+    // index of the lowest set bit, word must not be zero
+    inline uint32_t count_trailing_zeros(uint64_t word)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, word);
+        return static_cast<uint32_t>(idx);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(word));
+#endif
+    }
+
+    // index of the highest set bit, word must not be zero
+    inline uint32_t floor_log2(uint64_t word)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse64(&idx, word);
+        return static_cast<uint32_t>(idx);
+#else
+        return static_cast<uint32_t>(63 - __builtin_clzll(word));
+#endif
+    }
+
+    inline uint32_t count_ones(uint64_t word)
+    {
+#if defined(_MSC_VER)
+        return static_cast<uint32_t>(std::bitset<64>(word).count());
+#else
+        return static_cast<uint32_t>(__builtin_popcountll(word));
+#endif
+    }
+
+} // namespace do_ast
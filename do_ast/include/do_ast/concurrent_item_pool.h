@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <tuple>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+#include <do_ast/item_pool.h>
+
+namespace do_ast {
+
+    template<class... Args>
+    struct ConcurrentItemPoolTuple
+    {
+        // item pool tuple safe for concurrent insert, erase, contains and get from many threads.
+        //
+        // - new slots are reserved with an atomic counter.
+        // - erased slots go to a lock-free stack, its head is tagged with a counter against ABA.
+        // - smc of a slot is atomic: odd while occupied, even while free.
+        //   contains() compares it with the handle and stays valid under concurrency.
+        // - slots live in segments of geometrically growing size, reached through a fixed directory.
+        //   growth never moves slots, readers are never invalidated.
+        //
+        // clear() is not thread safe.
+
+        using size_type = std::size_t;
+        using FirstSegmentSize = std::integral_constant<std::size_t, 1024>;
+        using MaxSegments = std::integral_constant<std::size_t, 22>; // FirstSegmentSize * (2^22-1) slots fit into the 32 bit free list index
+        template<std::size_t K> using get_type = std::tuple_element_t<K, std::tuple<Args...>>;
+
+        ConcurrentItemPoolTuple();
+        ~ConcurrentItemPoolTuple();
+        ConcurrentItemPoolTuple(const ConcurrentItemPoolTuple&) = delete;
+        ConcurrentItemPoolTuple& operator=(const ConcurrentItemPoolTuple&) = delete;
+
+        template<std::size_t K>       get_type<K>& get(ItemPoolIndex idx);
+        template<std::size_t K> const get_type<K>& get(ItemPoolIndex idx) const;
+
+        void clear();
+
+        bool contains(ItemPoolIndex idx) const;
+        size_type size() const;
+
+        ItemPoolIndex insert();
+        template<class... Values> ItemPoolIndex insert(Values&&... values);
+
+        void erase(ItemPoolIndex idx);
+
+        ItemPoolIndex index(std::size_t index) const;
+
+    protected:
+        struct Segment
+        {
+            explicit Segment(std::size_t size);
+
+            std::unique_ptr<std::atomic<uint32_t>[]> smcs; // sequential modification counters
+            std::unique_ptr<std::atomic<uint32_t>[]> next_free; // free list links, slot index + 1, 0 ends the list
+            std::tuple<std::unique_ptr<Args[]>...> columns;
+        };
+
+        static std::size_t segment_size(std::size_t segment_idx);
+        static std::size_t segment_of(std::size_t index, std::size_t& offset);
+        Segment& segment_for_insert(std::size_t index);
+        std::atomic<uint32_t>& smc_of(std::size_t index) const;
+        uint32_t load_smc(std::size_t index) const;
+
+        template<std::size_t... Is, class... Values>
+        void assign(ItemPoolIndex idx, std::index_sequence<Is...>, Values&&... values);
+
+        static uint64_t make_head(uint32_t index_plus_one, uint32_t tag) { return (uint64_t(tag) << 32) | index_plus_one; }
+
+        std::array<std::atomic<Segment*>, MaxSegments::value> m_segments;
+        std::atomic<uint64_t> m_num_slots;
+        std::atomic<uint64_t> m_free_head; // low 32 bits: slot index + 1 of first free slot, high 32 bits: tag
+        std::atomic<int64_t> m_size;
+    };
+
+    template<class T>
+    struct ConcurrentItemPool : public ConcurrentItemPoolTuple<T>
+    {
+        using base_type = ConcurrentItemPoolTuple<T>;
+
+        T& get(ItemPoolIndex idx) { return base_type::template get<0>(idx); }
+        const T& get(ItemPoolIndex idx) const { return base_type::template get<0>(idx); }
+
+        using base_type::insert;
+        template <class... Args> ItemPoolIndex emplace(Args&&... args) { return this->insert(T(std::forward<Args>(args)...)); }
+    };
+
+} // namespace do_ast
+
+#include <do_ast/concurrent_item_pool.impl.h>
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <do_ast/bit_ops.h>
+#include <do_ast/concurrent_item_pool.h>
+
+namespace do_ast {
+
+    template<class... Args>
+    ConcurrentItemPoolTuple<Args...>::Segment::Segment(std::size_t size)
+        : smcs(new std::atomic<uint32_t>[size])
+        , next_free(new std::atomic<uint32_t>[size])
+        , columns(std::unique_ptr<Args[]>(new Args[size])...)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            smcs[i].store(0, std::memory_order_relaxed);
+            next_free[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    template<class... Args>
+    ConcurrentItemPoolTuple<Args...>::ConcurrentItemPoolTuple()
+        : m_num_slots(0)
+        , m_free_head(0)
+        , m_size(0)
+    {
+        for (auto& segment : m_segments)
+        {
+            segment.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    template<class... Args>
+    ConcurrentItemPoolTuple<Args...>::~ConcurrentItemPoolTuple()
+    {
+        for (auto& segment : m_segments)
+        {
+            delete segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    template<class... Args>
+    std::size_t ConcurrentItemPoolTuple<Args...>::segment_size(std::size_t segment_idx)
+    {
+        return FirstSegmentSize::value << segment_idx;
+    }
+
+    template<class... Args>
+    std::size_t ConcurrentItemPoolTuple<Args...>::segment_of(std::size_t index, std::size_t& offset)
+    {
+        // segment k holds the slots [F*(2^k-1), F*(2^(k+1)-1))
+        std::size_t segment_idx = floor_log2(index / FirstSegmentSize::value + 1);
+        offset = index - FirstSegmentSize::value * ((std::size_t(1) << segment_idx) - 1);
+        return segment_idx;
+    }
+
+    template<class... Args>
+    typename ConcurrentItemPoolTuple<Args...>::Segment& ConcurrentItemPoolTuple<Args...>::segment_for_insert(std::size_t index)
+    {
+        std::size_t offset;
+        auto segment_idx = segment_of(index, offset);
+        assert(segment_idx < MaxSegments::value);
+        Segment* segment = m_segments[segment_idx].load(std::memory_order_acquire);
+        if (segment == nullptr)
+        {
+            // several threads may race to allocate the same segment, only one wins
+            Segment* new_segment = new Segment(segment_size(segment_idx));
+            if (m_segments[segment_idx].compare_exchange_strong(segment, new_segment, std::memory_order_acq_rel))
+            {
+                segment = new_segment;
+            }
+            else
+            {
+                delete new_segment;
+            }
+        }
+        return *segment;
+    }
+
+    template<class... Args>
+    std::atomic<uint32_t>& ConcurrentItemPoolTuple<Args...>::smc_of(std::size_t index) const
+    {
+        std::size_t offset;
+        auto segment_idx = segment_of(index, offset);
+        return m_segments[segment_idx].load(std::memory_order_acquire)->smcs[offset];
+    }
+
+    template<class... Args>
+    uint32_t ConcurrentItemPoolTuple<Args...>::load_smc(std::size_t index) const
+    {
+        // the slot counter is bumped before its segment is published, a missing segment means a free slot
+        std::size_t offset;
+        auto segment_idx = segment_of(index, offset);
+        if (segment_idx >= MaxSegments::value) return 0;
+        const Segment* segment = m_segments[segment_idx].load(std::memory_order_acquire);
+        return segment ? segment->smcs[offset].load(std::memory_order_acquire) : 0;
+    }
+
+    template<class... Args>
+    ItemPoolIndex ConcurrentItemPoolTuple<Args...>::index(std::size_t index) const
+    {
+        auto smc = index < m_num_slots.load(std::memory_order_acquire) ? load_smc(index) : 0;
+        return ItemPoolIndex{index, smc};
+    }
+
+    template<class... Args>
+    template<std::size_t K>
+    std::tuple_element_t<K, std::tuple<Args...>>& ConcurrentItemPoolTuple<Args...>::get(ItemPoolIndex idx)
+    {
+        std::size_t offset;
+        auto segment_idx = segment_of(idx.index, offset);
+        return std::get<K>(m_segments[segment_idx].load(std::memory_order_acquire)->columns)[offset];
+    }
+
+    template<class... Args>
+    template<std::size_t K>
+    const std::tuple_element_t<K, std::tuple<Args...>>& ConcurrentItemPoolTuple<Args...>::get(ItemPoolIndex idx) const
+    {
+        std::size_t offset;
+        auto segment_idx = segment_of(idx.index, offset);
+        return std::get<K>(m_segments[segment_idx].load(std::memory_order_acquire)->columns)[offset];
+    }
+
+    template<class... Args>
+    void ConcurrentItemPoolTuple<Args...>::clear()
+    {
+        // erase all occupied slots but keep the segments and smcs, so stale handles stay invalid
+        auto num_slots = m_num_slots.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < num_slots; ++i)
+        {
+            auto& smc = smc_of(i);
+            if (smc.load(std::memory_order_relaxed) & 1) smc.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_num_slots.store(0, std::memory_order_release);
+        m_free_head.store(0, std::memory_order_release);
+        m_size.store(0, std::memory_order_release);
+    }
+
+    template<class... Args>
+    bool ConcurrentItemPoolTuple<Args...>::contains(ItemPoolIndex idx) const
+    {
+        return (idx.smc & 1)
+            && (idx.index < m_num_slots.load(std::memory_order_acquire))
+            && (load_smc(idx.index) == idx.smc);
+    }
+
+    template<class... Args>
+    typename ConcurrentItemPoolTuple<Args...>::size_type ConcurrentItemPoolTuple<Args...>::size() const
+    {
+        return static_cast<size_type>(m_size.load(std::memory_order_relaxed));
+    }
+
+    template<class... Args>
+    ItemPoolIndex ConcurrentItemPoolTuple<Args...>::insert()
+    {
+        std::size_t index;
+        uint64_t head = m_free_head.load(std::memory_order_acquire);
+        while (true)
+        {
+            uint32_t first = static_cast<uint32_t>(head);
+            if (first == 0)
+            {
+                // free list is empty, reserve a new slot
+                index = static_cast<std::size_t>(m_num_slots.fetch_add(1, std::memory_order_acq_rel));
+                segment_for_insert(index);
+                break;
+            }
+            std::size_t offset;
+            auto segment_idx = segment_of(first - 1, offset);
+            uint32_t next = m_segments[segment_idx].load(std::memory_order_acquire)->next_free[offset].load(std::memory_order_acquire);
+            // the tag changes on every push and pop, a stale next fails the exchange
+            if (m_free_head.compare_exchange_weak(head, make_head(next, static_cast<uint32_t>(head >> 32) + 1), std::memory_order_acq_rel))
+            {
+                index = first - 1;
+                break;
+            }
+        }
+        uint32_t smc = smc_of(index).fetch_add(1, std::memory_order_acq_rel) + 1;
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        return ItemPoolIndex{index, smc};
+    }
+
+    template<class... Args>
+    template<std::size_t... Is, class... Values>
+    void ConcurrentItemPoolTuple<Args...>::assign(ItemPoolIndex idx, std::index_sequence<Is...>, Values&&... values)
+    {
+        int expand[] = {0, (get<Is>(idx) = std::forward<Values>(values), 0)...};
+        (void)expand;
+    }
+
+    template<class... Args>
+    template<class... Values>
+    ItemPoolIndex ConcurrentItemPoolTuple<Args...>::insert(Values&&... values)
+    {
+        static_assert(sizeof...(Values) == sizeof...(Args), "insert needs one value per column.");
+        ItemPoolIndex new_idx = insert();
+        assign(new_idx, std::index_sequence_for<Args...>(), std::forward<Values>(values)...);
+        return new_idx;
+    }
+
+    template<class... Args>
+    void ConcurrentItemPoolTuple<Args...>::erase(ItemPoolIndex idx)
+    {
+        if (!contains(idx)) return;
+        // only one of several concurrent erase calls with the same handle wins
+        uint32_t expected = idx.smc;
+        if (!smc_of(idx.index).compare_exchange_strong(expected, idx.smc + 1, std::memory_order_acq_rel)) return;
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+
+        std::size_t offset;
+        auto segment_idx = segment_of(idx.index, offset);
+        auto& next_free = m_segments[segment_idx].load(std::memory_order_acquire)->next_free[offset];
+        uint64_t head = m_free_head.load(std::memory_order_acquire);
+        do
+        {
+            next_free.store(static_cast<uint32_t>(head), std::memory_order_release);
+        }
+        while (!m_free_head.compare_exchange_weak(head, make_head(static_cast<uint32_t>(idx.index + 1), static_cast<uint32_t>(head >> 32) + 1), std::memory_order_acq_rel));
+    }
+
+} // namespace do_ast
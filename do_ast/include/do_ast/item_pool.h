@@ -2,40 +2,122 @@
 
 #include <vector>
 
+#include <do_ast/item_pool_storage.h>
+#include <do_ast/occupancy_bitmap.h>
+
 namespace do_ast {
 
-    struct ItemPoolIndex
+    template<class TIndex>
+    struct ItemPoolRange_
     {
-        std::size_t index = 0;
-        uint32_t smc = 0; // sequential modification counter
+        // contiguous slots created together by a bulk insert, all sharing one smc
+        using Index = TIndex;
+
+        std::size_t first = 0;
+        std::size_t count = 0;
+        uint32_t smc = 0;
+
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        Index operator[](std::size_t k) const { return Index{first + k, smc}; }
+        Index front() const { return (*this)[0]; }
+        Index back() const { return (*this)[count - 1]; }
+    };
+
+    template<class TIndex>
+    struct ItemPoolRemap_
+    {
+        // result of compacting a pool: maps handles of the old slots to their new handles
+        using Index = TIndex;
+
+        std::vector<Index> new_index;
+        std::vector<uint32_t> old_smcs;
+
+        // returns the new handle, or the invalid handle Index{} if old_idx was not valid
+        Index operator()(Index old_idx) const
+        {
+            if ((old_idx.index >= new_index.size()) || (old_smcs[old_idx.index] != old_idx.smc)) return Index();
+            return new_index[old_idx.index];
+        }
     };
+
+    using ItemPoolRange = ItemPoolRange_<ItemPoolIndex>;
+    using ItemPoolRemap = ItemPoolRemap_<ItemPoolIndex>;
+
+    template<class TIndex, class Container>
+    void remap_handles(const ItemPoolRemap_<TIndex>& remap, Container& handles)
+    {
+        for (auto& handle : handles)
+        {
+            handle = remap(handle);
+        }
+    }
     
 
-    template<class T>
+    template<class T, class TPolicy = ItemPoolPolicy<>>
     struct ItemPool
     {
-        using size_type = typename std::vector<T>::size_type;
-        //using index_type = size_type;
+        using Policy = TPolicy;
+        using slots_type = typename Policy::Storage::template slots_type<T>;
+        using size_type = typename slots_type::size_type;
+        using Index = typename Policy::Index;
+        using IndexTraits = ItemPoolIndexTraits<Index>;
+        using Range = ItemPoolRange_<Index>;
+        using Remap = ItemPoolRemap_<Index>;
+        using allocator_type = typename Policy::Storage::allocator_type;
+        template<class U> using container_type = typename Policy::Storage::template container_type<U>;
+        using bitmap_type = OccupancyBitmap_<rebind_alloc_t<allocator_type, OccupancyBitmap::Word>>;
+        using free_list_type = typename Policy::Reuse::template free_list_type<container_type<Index>>;
 
-        T& get(ItemPoolIndex idx);
-        const T& get(ItemPoolIndex idx) const;
-        T& at(ItemPoolIndex idx);
-        const T& at(ItemPoolIndex idx) const;
+        ItemPool() = default;
+        explicit ItemPool(const allocator_type& alloc);
+        allocator_type get_allocator() const { return allocator_type(m_slot_smcs.get_allocator()); }
+
+        T& get(Index idx);
+        const T& get(Index idx) const;
+        T& at(Index idx);
+        const T& at(Index idx) const;
         void clear();
+        // O(1) clear that keeps all capacity and the constructed slots, later inserts assign into them.
+        // all outstanding handles become invalid: their slots are past the end or get a new smc when reused.
+        void reset();
         size_type size() const;
-        ItemPoolIndex insert();
-        ItemPoolIndex insert(const T& value);
-        template <class... Args> ItemPoolIndex emplace(Args... args);
-        void erase(ItemPoolIndex idx);
-        bool contains(ItemPoolIndex idx) const;
+        Index insert();
+        Index insert(const T& value);
+        Index insert(T&& value);
+        // constructs the item in place from args, a reused slot is move assigned from T(args...)
+        template <class... Args> Index emplace(Args&&... args);
+        // bulk inserts, always append contiguous slots at the end and ignore free slots
+        Range insert_n(size_type count);
+        Range insert_n(size_type count, const T& value);
+        template <class Iterator> Range emplace_range(Iterator first, Iterator last);
+        void reserve(size_type capacity);
+        // moves live slots to the front and releases the unused capacity.
+        // handles of moved slots change, the returned remap translates them.
+        Remap compact();
+        void erase(Index idx);
+        bool contains(Index idx) const;
+
+        Index index(std::size_t index) const;
 
-        ItemPoolIndex index(std::size_t index) const;
+        // calls callback(Index, T&) for each live slot in ascending slot order
+        template <class Callback> void for_each_live(Callback callback);
+        template <class Callback> void for_each_live(Callback callback) const;
+        // range over the slot indices of all live slots
+        typename bitmap_type::SetBits live() const { return m_occupied_slots.set_bits(); }
+        const bitmap_type& occupancy() const { return m_occupied_slots; }
 
     protected:
-        std::vector<T> m_slots;
-        std::vector<uint32_t> m_slot_smcs; // sequential modification counters
-        std::vector<bool> m_occupied_slots;
-        std::vector<ItemPoolIndex> m_free_slot_ids;
+        uint32_t fresh_slot_smc(std::size_t index);
+        uint32_t fresh_range_smc(std::size_t first, std::size_t count);
+        void bump_smc(std::size_t index) { m_slot_smcs[index] = IndexTraits::next_smc(m_slot_smcs[index]); }
+        template <class... Args> void append_slot(Args&&... args);
+
+        slots_type m_slots;
+        std::size_t m_num_slots = 0; // slots in use, m_slots past it holds slots kept by reset()
+        container_type<uint32_t> m_slot_smcs; // sequential modification counters, kept for released slots so stale handles stay invalid
+        bitmap_type m_occupied_slots;
+        free_list_type m_free_slot_ids;
     };
 
 } // namespace do_ast
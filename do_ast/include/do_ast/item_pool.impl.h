@@ -1,111 +1,306 @@
 #pragma once
 
+#include <iterator>
+#include <algorithm>
+#include <utility>
+
 #include <do_ast/item_pool.h>
 
 namespace do_ast {
 
-    template<class T>
-    ItemPoolIndex ItemPool<T>::index(std::size_t index) const
+    template<class T, class TPolicy>
+    ItemPool<T, TPolicy>::ItemPool(const allocator_type& alloc)
+    : m_slots(alloc)
+    , m_slot_smcs(alloc)
+    , m_occupied_slots(alloc)
+    , m_free_slot_ids(alloc)
+    {}
+
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::Index ItemPool<T, TPolicy>::index(std::size_t index) const
     {
         auto smc = index < m_slot_smcs.size() ? m_slot_smcs[index] : 0;
-        return ItemPoolIndex{index, smc};
+        return Index{index, smc};
     }
     
-    template<class T>
-    T& ItemPool<T>::get(ItemPoolIndex idx)
+    template<class T, class TPolicy>
+    T& ItemPool<T, TPolicy>::get(Index idx)
     {
         return m_slots[idx.index];
     }
     
-    template<class T>
-    const T& ItemPool<T>::get(ItemPoolIndex idx) const
+    template<class T, class TPolicy>
+    const T& ItemPool<T, TPolicy>::get(Index idx) const
     {
         return m_slots[idx.index];
     }
     
-    template<class T>
-    T& ItemPool<T>::at(ItemPoolIndex idx)
+    template<class T, class TPolicy>
+    T& ItemPool<T, TPolicy>::at(Index idx)
     {
         assert(contains(idx));
         return m_slots.at(idx.index);
     }
     
-    template<class T>
-    const T& ItemPool<T>::at(ItemPoolIndex idx) const
+    template<class T, class TPolicy>
+    const T& ItemPool<T, TPolicy>::at(Index idx) const
     {
         assert(contains(idx));
         return m_slots.at(idx.index);
     }
     
-    template<class T>
-    void ItemPool<T>::clear()
+    template<class T, class TPolicy>
+    void ItemPool<T, TPolicy>::clear()
     {
         m_slots.clear();
+        m_num_slots = 0;
         m_occupied_slots.clear();
         m_free_slot_ids.clear();
     }
+
+    template<class T, class TPolicy>
+    void ItemPool<T, TPolicy>::reset()
+    {
+        m_num_slots = 0;
+        m_occupied_slots.truncate(0);
+        m_free_slot_ids.clear();
+    }
     
-    template<class T>
-    typename ItemPool<T>::size_type ItemPool<T>::size() const
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::size_type ItemPool<T, TPolicy>::size() const
     {
-        return m_slots.size() - m_free_slot_ids.size();
+        return m_num_slots - m_free_slot_ids.size();
     }
     
-    template<class T>
-    ItemPoolIndex ItemPool<T>::insert()
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::Index ItemPool<T, TPolicy>::insert()
     {
         if (m_free_slot_ids.size() > 0)
         {
-            ItemPoolIndex new_idx;
-            new_idx.index = m_free_slot_ids.back().index;
-            m_slot_smcs[new_idx.index]++;
+            Index new_idx;
+            new_idx.index = m_free_slot_ids.pop().index;
+            bump_smc(new_idx.index);
             new_idx.smc = m_slot_smcs[new_idx.index];
-            m_free_slot_ids.pop_back();
-            m_occupied_slots[new_idx.index] = true;
+            m_occupied_slots.set(new_idx.index);
             return new_idx;
         }
         else
         {
-            ItemPoolIndex new_idx;
-            new_idx.index = m_slots.size();
-            new_idx.smc = 1;
-            m_slots.emplace_back();
-            m_slot_smcs.emplace_back(new_idx.smc);
+            Index new_idx;
+            assert(m_num_slots <= IndexTraits::max_index());
+            new_idx.index = m_num_slots;
+            new_idx.smc = fresh_slot_smc(new_idx.index);
+            append_slot();
             m_occupied_slots.push_back(true);
             return new_idx;
         }
     }
     
-    template<class T>
-    ItemPoolIndex ItemPool<T>::insert(const T& value)
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::Index ItemPool<T, TPolicy>::insert(const T& value)
+    {
+        return emplace(value);
+    }
+    
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::Index ItemPool<T, TPolicy>::insert(T&& value)
     {
-        ItemPoolIndex new_idx = insert();
-        m_slots[new_idx.index] = value;
-        return new_idx;
+        return emplace(std::move(value));
     }
     
-    template<class T>
+    template<class T, class TPolicy>
     template<class... Args>
-    ItemPoolIndex ItemPool<T>::emplace(Args... args)
+    typename ItemPool<T, TPolicy>::Index ItemPool<T, TPolicy>::emplace(Args&&... args)
     {
-        ItemPoolIndex new_idx = insert();
-        m_slots[new_idx.index] = T(args...);
-        return new_idx;
+        if (m_free_slot_ids.size() > 0)
+        {
+            Index new_idx = insert();
+            m_slots[new_idx.index] = T(std::forward<Args>(args)...);
+            return new_idx;
+        }
+        else
+        {
+            Index new_idx;
+            assert(m_num_slots <= IndexTraits::max_index());
+            new_idx.index = m_num_slots;
+            new_idx.smc = fresh_slot_smc(new_idx.index);
+            append_slot(std::forward<Args>(args)...);
+            m_occupied_slots.push_back(true);
+            return new_idx;
+        }
+    }
+
+    template<class T, class TPolicy>
+    template<class... Args>
+    void ItemPool<T, TPolicy>::append_slot(Args&&... args)
+    {
+        // slots kept by reset() are reused before the storage grows
+        if (m_num_slots < m_slots.size())
+        {
+            m_slots[m_num_slots] = T(std::forward<Args>(args)...);
+        }
+        else
+        {
+            m_slots.emplace_back(std::forward<Args>(args)...);
+        }
+        ++m_num_slots;
     }
     
-    template<class T>
-    void ItemPool<T>::erase(ItemPoolIndex idx)
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::Range ItemPool<T, TPolicy>::insert_n(size_type count)
+    {
+        Range range;
+        range.first = m_num_slots;
+        range.count = count;
+        range.smc = fresh_range_smc(range.first, count);
+        auto num_kept = std::min(count, m_slots.size() - m_num_slots);
+        for (size_type k = 0; k < num_kept; ++k)
+        {
+            m_slots[range.first + k] = T();
+        }
+        m_slots.resize(std::max(m_slots.size(), range.first + count));
+        m_num_slots = range.first + count;
+        m_occupied_slots.resize(range.first + count, true);
+        return range;
+    }
+
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::Range ItemPool<T, TPolicy>::insert_n(size_type count, const T& value)
+    {
+        Range range;
+        range.first = m_num_slots;
+        range.count = count;
+        range.smc = fresh_range_smc(range.first, count);
+        m_slots.reserve(range.first + count);
+        for (size_type k = 0; k < count; ++k)
+        {
+            append_slot(value);
+        }
+        m_occupied_slots.resize(range.first + count, true);
+        return range;
+    }
+
+    template<class T, class TPolicy>
+    template<class Iterator>
+    typename ItemPool<T, TPolicy>::Range ItemPool<T, TPolicy>::emplace_range(Iterator first, Iterator last)
+    {
+        Range range;
+        range.first = m_num_slots;
+        range.count = std::distance(first, last);
+        range.smc = fresh_range_smc(range.first, range.count);
+        m_slots.reserve(range.first + range.count);
+        for (; first != last; ++first)
+        {
+            append_slot(*first);
+        }
+        m_occupied_slots.resize(range.first + range.count, true);
+        return range;
+    }
+
+    template<class T, class TPolicy>
+    void ItemPool<T, TPolicy>::reserve(size_type capacity)
+    {
+        m_slots.reserve(capacity);
+        m_slot_smcs.reserve(capacity);
+        m_occupied_slots.reserve(capacity);
+    }
+    
+    template<class T, class TPolicy>
+    uint32_t ItemPool<T, TPolicy>::fresh_slot_smc(std::size_t index)
+    {
+        // slots released by compact() or clear() keep their smc, continue counting from there
+        if (index < m_slot_smcs.size())
+        {
+            bump_smc(index);
+            return m_slot_smcs[index];
+        }
+        m_slot_smcs.push_back(1);
+        return 1;
+    }
+
+    template<class T, class TPolicy>
+    uint32_t ItemPool<T, TPolicy>::fresh_range_smc(std::size_t first, std::size_t count)
+    {
+        // all slots of a range share one smc, it must be newer than all previous smcs of these slots.
+        // narrow smcs may wrap around, then only the largest previous smc is guaranteed to differ.
+        assert((count == 0) || (first + count - 1 <= IndexTraits::max_index()));
+        uint32_t max_smc = 0;
+        auto num_known = (first < m_slot_smcs.size()) ? std::min(count, m_slot_smcs.size() - first) : 0;
+        for (std::size_t k = 0; k < num_known; ++k)
+        {
+            max_smc = std::max(max_smc, m_slot_smcs[first + k]);
+        }
+        uint32_t smc = IndexTraits::next_smc(max_smc);
+        std::fill(m_slot_smcs.begin() + first, m_slot_smcs.begin() + first + num_known, smc);
+        m_slot_smcs.resize(std::max(m_slot_smcs.size(), first + count), smc);
+        return smc;
+    }
+
+    template<class T, class TPolicy>
+    typename ItemPool<T, TPolicy>::Remap ItemPool<T, TPolicy>::compact()
+    {
+        Remap remap;
+        auto num_slots = m_num_slots;
+        remap.new_index.resize(num_slots);
+        remap.old_smcs.assign(m_slot_smcs.begin(), m_slot_smcs.begin() + num_slots);
+
+        std::size_t num_live = 0;
+        for (std::size_t src = 0; src < num_slots; ++src)
+        {
+            if (!m_occupied_slots[src]) continue;
+            auto dst = num_live++;
+            if (dst != src)
+            {
+                // dst is a free slot, its smc is already newer than any handle to it
+                m_slots[dst] = std::move(m_slots[src]);
+                bump_smc(dst);
+                bump_smc(src);
+            }
+            remap.new_index[src] = Index{dst, m_slot_smcs[dst]};
+        }
+
+        m_slots.resize(num_live);
+        m_slots.shrink_to_fit();
+        m_num_slots = num_live;
+        m_occupied_slots.assign(num_live, true);
+        m_occupied_slots.shrink_to_fit();
+        m_free_slot_ids.clear();
+        m_free_slot_ids.shrink_to_fit();
+        return remap;
+    }
+    
+    template<class T, class TPolicy>
+    void ItemPool<T, TPolicy>::erase(Index idx)
+    {
+        // stale handles, also those from before a reset, are ignored
+        if (!contains(idx)) return;
+        bump_smc(idx.index);
+        m_occupied_slots.reset(idx.index);
+        m_free_slot_ids.push(idx);
+    }
+    
+    template<class T, class TPolicy>
+    template<class Callback>
+    void ItemPool<T, TPolicy>::for_each_live(Callback callback)
+    {
+        m_occupied_slots.for_each_set([this, &callback](std::size_t i) {
+            callback(Index{i, m_slot_smcs[i]}, m_slots[i]);
+        });
+    }
+
+    template<class T, class TPolicy>
+    template<class Callback>
+    void ItemPool<T, TPolicy>::for_each_live(Callback callback) const
     {
-        if (!m_occupied_slots[idx.index]) return;
-        m_slot_smcs[idx.index]++;
-        m_occupied_slots[idx.index] = false;
-        m_free_slot_ids.push_back(idx);
+        m_occupied_slots.for_each_set([this, &callback](std::size_t i) {
+            callback(Index{i, m_slot_smcs[i]}, m_slots[i]);
+        });
     }
     
-    template<class T>
-    bool ItemPool<T>::contains(ItemPoolIndex idx) const
+    template<class T, class TPolicy>
+    bool ItemPool<T, TPolicy>::contains(Index idx) const
     {
-        return m_occupied_slots[idx.index] && (m_slot_smcs[idx.index] == idx.smc);
+        return (idx.index < m_occupied_slots.size()) && m_occupied_slots[idx.index] && (m_slot_smcs[idx.index] == idx.smc);
     }
 
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace do_ast {
+
+    struct ItemPoolIndex
+    {
+        using IndexBits = std::integral_constant<unsigned, std::numeric_limits<std::size_t>::digits>;
+        using SmcBits = std::integral_constant<unsigned, 32>;
+
+        std::size_t index = 0;
+        uint32_t smc = 0; // sequential modification counter
+    };
+
+    template<class TWord, unsigned TIndexBits>
+    struct PackedItemPoolIndex
+    {
+        // index and smc packed into bit fields of a single word.
+        // e.g. 32+32 bits in uint64_t or 24+8 bits in uint32_t instead of the 16 bytes of ItemPoolIndex.
+        using Word = TWord;
+        using IndexBits = std::integral_constant<unsigned, TIndexBits>;
+        using SmcBits = std::integral_constant<unsigned, std::numeric_limits<TWord>::digits - TIndexBits>;
+
+        static_assert(std::is_unsigned<TWord>::value, "TWord must be an unsigned integer.");
+        static_assert((IndexBits::value > 0) && (IndexBits::value <= std::numeric_limits<std::size_t>::digits), "index does not fit into std::size_t.");
+        static_assert((SmcBits::value > 0) && (SmcBits::value <= 32), "smc needs 1 to 32 bits.");
+
+        TWord index : IndexBits::value;
+        TWord smc : SmcBits::value; // sequential modification counter
+
+        PackedItemPoolIndex() : index(0), smc(0) {}
+        PackedItemPoolIndex(std::size_t index, uint32_t smc) : index(static_cast<TWord>(index)), smc(static_cast<TWord>(smc)) {}
+    };
+
+    using ItemPoolIndex32 = PackedItemPoolIndex<uint64_t, 32>; // up to 2^32 slots, 2^32 generations
+    using ItemPoolIndex24 = PackedItemPoolIndex<uint32_t, 24>; // up to 2^24 slots, 2^8 generations
+
+    template<class TIndex>
+    struct ItemPoolIndexTraits
+    {
+        using Index = TIndex;
+        using IndexBits = typename Index::IndexBits;
+        using SmcBits = typename Index::SmcBits;
+
+        static constexpr std::size_t max_index() { return ~std::size_t(0) >> (std::numeric_limits<std::size_t>::digits - IndexBits::value); }
+        static constexpr uint32_t smc_mask() { return ~uint32_t(0) >> (32 - SmcBits::value); }
+
+        // smc following smc, wraps around inside the smc bits.
+        // skips 0, which is reserved for the invalid handle Index{}.
+        static uint32_t next_smc(uint32_t smc)
+        {
+            smc = (smc + 1) & smc_mask();
+            return (smc == 0) ? 1 : smc;
+        }
+    };
+
+} // namespace do_ast
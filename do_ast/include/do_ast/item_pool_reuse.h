@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace do_ast {
+
+    // reuse policies select which free slot an insert into ItemPool or ItemPoolTuple takes.
+    // the free list stores the handles of erased slots in the container TContainer.
+
+    template<class TContainer>
+    struct LifoFreeList
+    {
+        // most recently freed slot first, O(1)
+        using container_type = TContainer;
+        using value_type = typename TContainer::value_type;
+        using allocator_type = typename TContainer::allocator_type;
+
+        LifoFreeList() = default;
+        explicit LifoFreeList(const allocator_type& alloc) : m_ids(alloc) {}
+
+        std::size_t size() const { return m_ids.size(); }
+        bool empty() const { return m_ids.empty(); }
+        void clear() { m_ids.clear(); }
+        void shrink_to_fit() { m_ids.shrink_to_fit(); }
+
+        void push(const value_type& id) { m_ids.push_back(id); }
+        value_type pop()
+        {
+            auto id = m_ids.back();
+            m_ids.pop_back();
+            return id;
+        }
+
+    protected:
+        TContainer m_ids;
+    };
+
+    template<class TContainer>
+    struct LowestIndexFreeList
+    {
+        // lowest free slot first, O(log n) min-heap on the slot index.
+        // new items fill the holes at the front, so the live slots stay dense.
+        using container_type = TContainer;
+        using value_type = typename TContainer::value_type;
+        using allocator_type = typename TContainer::allocator_type;
+
+        LowestIndexFreeList() = default;
+        explicit LowestIndexFreeList(const allocator_type& alloc) : m_ids(alloc) {}
+
+        std::size_t size() const { return m_ids.size(); }
+        bool empty() const { return m_ids.empty(); }
+        void clear() { m_ids.clear(); }
+        void shrink_to_fit() { m_ids.shrink_to_fit(); }
+
+        void push(const value_type& id)
+        {
+            m_ids.push_back(id);
+            std::push_heap(m_ids.begin(), m_ids.end(), HigherIndex());
+        }
+        value_type pop()
+        {
+            std::pop_heap(m_ids.begin(), m_ids.end(), HigherIndex());
+            auto id = m_ids.back();
+            m_ids.pop_back();
+            return id;
+        }
+
+    protected:
+        struct HigherIndex
+        {
+            bool operator()(const value_type& a, const value_type& b) const { return a.index > b.index; }
+        };
+
+        TContainer m_ids;
+    };
+
+    struct LifoReuse
+    {
+        template<class TContainer> using free_list_type = LifoFreeList<TContainer>;
+    };
+
+    struct LowestIndexReuse
+    {
+        template<class TContainer> using free_list_type = LowestIndexFreeList<TContainer>;
+    };
+
+} // namespace do_ast
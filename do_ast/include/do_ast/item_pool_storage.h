@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <do_ast/arena_allocator.h>
+#include <do_ast/aligned_allocator.h>
+#include <do_ast/segmented_vector.h>
+#include <do_ast/item_pool_index.h>
+#include <do_ast/item_pool_reuse.h>
+
+namespace do_ast {
+
+    // storage policies select the container used for the slots of ItemPool and ItemPoolTuple.
+    // the allocator is rebound to every container of a pool, including its bookkeeping.
+
+    template<class TAllocator = std::allocator<char>>
+    struct VectorStorage_
+    {
+        // contiguous slots, data() is available.
+        // growth reallocates and moves all slots, references are invalidated.
+        using allocator_type = TAllocator;
+        template<class T> using container_type = std::vector<T, rebind_alloc_t<TAllocator, T>>;
+        template<class T> using slots_type = container_type<T>;
+    };
+
+    using VectorStorage = VectorStorage_<>;
+
+    template<std::size_t TSegmentSize = 4096, class TAllocator = std::allocator<char>>
+    struct SegmentedStorage
+    {
+        // slots stored in fixed size segments.
+        // growth is O(1) without copying, references stay valid.
+        using allocator_type = TAllocator;
+        template<class T> using container_type = std::vector<T, rebind_alloc_t<TAllocator, T>>;
+        template<class T> using slots_type = SegmentedVector<T, TSegmentSize, rebind_alloc_t<TAllocator, T>>;
+    };
+
+    template<std::size_t TAlignment = 64, class TAllocator = std::allocator<char>>
+    struct AlignedStorage
+    {
+        // contiguous slots for simd kernels over slots<K>().data().
+        // data() is TAlignment aligned, at least one TAlignment block past the capacity is readable and writable.
+        using allocator_type = TAllocator;
+        template<class T> using container_type = std::vector<T, rebind_alloc_t<TAllocator, T>>;
+        template<class T> using slots_type = std::vector<T, AlignedAllocator<T, TAlignment, rebind_alloc_t<TAllocator, char>>>;
+    };
+
+    template<class TStorage = VectorStorage, class TIndex = ItemPoolIndex, class TReuse = LifoReuse>
+    struct ItemPoolPolicy
+    {
+        using Storage = TStorage;
+        using Index = TIndex; // handle type, see item_pool_index.h
+        using Reuse = TReuse; // free slot order, see item_pool_reuse.h
+    };
+
+} // namespace do_ast
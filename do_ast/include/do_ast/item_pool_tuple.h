@@ -2,51 +2,97 @@
 
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include <do_ast/item_pool.h>
+#include <do_ast/lazy_column.h>
 
 namespace do_ast {
 
-    template<class... Args>
-    struct ItemPoolTuple
+    template<class TPolicy, class... Args>
+    struct ItemPoolTuple_
     {
-        using tuple_type = std::tuple<std::vector<Args>...>;
+        using Policy = TPolicy;
+        // a column declared as Lazy<T> is a sparse LazyColumn<T>, see lazy_column.h
+        template<class T> using slots_type = typename ColumnTraits<T>::template slots_type<typename Policy::Storage>;
+        using tuple_type = std::tuple<slots_type<Args>...>;
         using num_types = std::tuple_size<tuple_type>;
         using size_type = typename std::vector<int>::size_type;
-        template<std::size_t K> using get_type = std::tuple_element_t<K, std::tuple<Args...>>;
+        template<std::size_t K> using get_type = column_value_t<std::tuple_element_t<K, std::tuple<Args...>>>;
         template<std::size_t K> using get_slots_type = std::tuple_element_t<K, tuple_type>;
+        using Index = typename Policy::Index;
+        using IndexTraits = ItemPoolIndexTraits<Index>;
+        using Remap = ItemPoolRemap_<Index>;
+        using allocator_type = typename Policy::Storage::allocator_type;
+        template<class U> using container_type = typename Policy::Storage::template container_type<U>;
+        using bitmap_type = OccupancyBitmap_<rebind_alloc_t<allocator_type, OccupancyBitmap::Word>>;
+        using free_list_type = typename Policy::Reuse::template free_list_type<container_type<Index>>;
         
+        ItemPoolTuple_() = default;
+        explicit ItemPoolTuple_(const allocator_type& alloc);
+        allocator_type get_allocator() const { return allocator_type(m_slot_smcs.get_allocator()); }
+
         template<std::size_t K>       get_slots_type<K>& slots();
         template<std::size_t K> const get_slots_type<K>& slots() const;
-        template<std::size_t K>       get_type<K>& get(ItemPoolIndex idx);
-        template<std::size_t K> const get_type<K>& get(ItemPoolIndex idx) const;
-        template<std::size_t K>       get_type<K>& at(ItemPoolIndex idx);
-        template<std::size_t K> const get_type<K>& at(ItemPoolIndex idx) const;
+        template<std::size_t K>       get_type<K>& get(Index idx);
+        template<std::size_t K> const get_type<K>& get(Index idx) const;
+        template<std::size_t K>       get_type<K>& at(Index idx);
+        template<std::size_t K> const get_type<K>& at(Index idx) const;
 
         void clear();
+        // O(1) clear that keeps all capacity and the constructed slots of every column, later inserts assign into them.
+        // all outstanding handles become invalid: their slots are past the end or get a new smc when reused.
+        void reset();
 
-        bool contains(ItemPoolIndex idx) const;
+        bool contains(Index idx) const;
         size_type size() const;
 
-        ItemPoolIndex insert();
-        ItemPoolIndex insert(Args... value);
+        Index insert();
+        // one value per column, forwarded into the columns
+        template<class... Values> Index insert(Values&&... values);
 
-        void erase(ItemPoolIndex idx);
+        void erase(Index idx);
+
+        // moves live slots to the front and releases the unused capacity.
+        // handles of moved slots change, the returned remap translates them.
+        Remap compact();
 
         template<class SlotsVisitor>
         void visit_slots(SlotsVisitor& slots_visitor);
         
-        ItemPoolIndex index(std::size_t index) const;
+        Index index(std::size_t index) const;
+
+        // calls callback(Index) for each live slot in ascending slot order
+        template<class Callback> void for_each_live(Callback callback) const;
+        // column projected: calls callback(Index, get_type<K>&) for each live slot
+        template<std::size_t K, class Callback> void for_each_live(Callback callback);
+        template<std::size_t K, class Callback> void for_each_live(Callback callback) const;
+        // range over the slot indices of all live slots
+        typename bitmap_type::SetBits live() const { return m_occupied_slots.set_bits(); }
+        const bitmap_type& occupancy() const { return m_occupied_slots; }
+
+        // allocated bytes of all columns
+        std::size_t columns_bytes() const { return columns_bytes(std::index_sequence_for<Args...>()); }
 
     protected:
+        uint32_t fresh_slot_smc(std::size_t index);
+        template<std::size_t... Is, class... Values> void emplace_back_columns(std::index_sequence<Is...>, Values&&... values);
+        template<std::size_t... Is> std::size_t columns_bytes(std::index_sequence<Is...>) const;
+        template<std::size_t... Is, class... Values> void assign_columns(std::size_t index, std::index_sequence<Is...>, Values&&... values);
+        void bump_smc(std::size_t index) { m_slot_smcs[index] = IndexTraits::next_smc(m_slot_smcs[index]); }
+        // slots in use are tracked by m_occupied_slots, the columns may hold more slots kept by reset()
+        std::size_t num_constructed_slots() const { return std::get<0>(m_slots).size(); }
 
-        std::tuple<std::vector<Args>...> m_slots;
-        std::vector<uint32_t> m_slot_smcs; // sequential modification counters
-        std::vector<bool> m_occupied_slots;
-        std::vector<ItemPoolIndex> m_free_slot_ids;
+        tuple_type m_slots;
+        container_type<uint32_t> m_slot_smcs; // sequential modification counters, kept for released slots so stale handles stay invalid
+        bitmap_type m_occupied_slots;
+        free_list_type m_free_slot_ids;
         std::size_t m_size = 0;
     };
 
+    template<class... Args>
+    using ItemPoolTuple = ItemPoolTuple_<ItemPoolPolicy<>, Args...>;
+
 } // namespace do_ast
 
 #include <do_ast/item_pool_tuple.impl.h>
\ No newline at end of file
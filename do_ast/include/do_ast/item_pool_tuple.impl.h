@@ -4,52 +4,60 @@
 
 namespace do_ast {
 
-    template<class... Args>
-    ItemPoolIndex ItemPoolTuple<Args...>::index(std::size_t index) const
+    template<class TPolicy, class... Args>
+    ItemPoolTuple_<TPolicy, Args...>::ItemPoolTuple_(const allocator_type& alloc)
+    : m_slots(slots_type<Args>(alloc)...)
+    , m_slot_smcs(alloc)
+    , m_occupied_slots(alloc)
+    , m_free_slot_ids(alloc)
+    {}
+
+    template<class TPolicy, class... Args>
+    typename ItemPoolTuple_<TPolicy, Args...>::Index ItemPoolTuple_<TPolicy, Args...>::index(std::size_t index) const
     {
         auto smc = index < m_slot_smcs.size() ? m_slot_smcs[index] : 0;
-        return ItemPoolIndex{index, smc};
+        return Index{index, smc};
     }
 
-    template<class... Args>
+    template<class TPolicy, class... Args>
     template<std::size_t K>
-    std::tuple_element_t<K, std::tuple<std::vector<Args>...>>& ItemPoolTuple<Args...>::slots()
+    typename ItemPoolTuple_<TPolicy, Args...>::template get_slots_type<K>& ItemPoolTuple_<TPolicy, Args...>::slots()
     {
         return std::get<K>(m_slots);
     }
     
-    template<class... Args>
+    template<class TPolicy, class... Args>
     template<std::size_t K>
-    const std::tuple_element_t<K, std::tuple<std::vector<Args>...>>& ItemPoolTuple<Args...>::slots() const
+    const typename ItemPoolTuple_<TPolicy, Args...>::template get_slots_type<K>& ItemPoolTuple_<TPolicy, Args...>::slots() const
     {
         return std::get<K>(m_slots);
     }
     
-    template<class... Args>
+    template<class TPolicy, class... Args>
     template<std::size_t K>
-    std::tuple_element_t<K, std::tuple<Args...>>& ItemPoolTuple<Args...>::get(ItemPoolIndex idx)
+    typename ItemPoolTuple_<TPolicy, Args...>::template get_type<K>& ItemPoolTuple_<TPolicy, Args...>::get(Index idx)
     {
         return std::get<K>(m_slots)[idx.index];
     }
     
-    template<class... Args>
+    template<class TPolicy, class... Args>
     template<std::size_t K>
-    const std::tuple_element_t<K, std::tuple<Args...>>& ItemPoolTuple<Args...>::get(ItemPoolIndex idx) const
+    const typename ItemPoolTuple_<TPolicy, Args...>::template get_type<K>& ItemPoolTuple_<TPolicy, Args...>::get(Index idx) const
     {
         return std::get<K>(m_slots)[idx.index];
     }
     
-    template<class... Args>
+    template<class TPolicy, class... Args>
     template<std::size_t K>
-    std::tuple_element_t<K, std::tuple<Args...>>& ItemPoolTuple<Args...>::at(ItemPoolIndex idx)
+    typename ItemPoolTuple_<TPolicy, Args...>::template get_type<K>& ItemPoolTuple_<TPolicy, Args...>::at(Index idx)
     {
         assert(contains(idx));
         return std::get<K>(m_slots).at(idx.index);
     }
     
-    template<class... Args>
+    template<class TPolicy, class... Args>
     template<std::size_t K>
-    const std::tuple_element_t<K, std::tuple<Args...>>& ItemPoolTuple<Args...>::at(ItemPoolIndex idx) const
+    const typename ItemPoolTuple_<TPolicy, Args...>::template get_type<K>& ItemPoolTuple_<TPolicy, Args...>::at(Index idx) const
     {
         assert(contains(idx));
         return std::get<K>(m_slots).at(idx.index);
@@ -64,18 +72,27 @@ namespace do_ast {
         }
     };
 
-    template<class... Args>
-    void ItemPoolTuple<Args...>::clear()
+    template<class TPolicy, class... Args>
+    void ItemPoolTuple_<TPolicy, Args...>::clear()
     {
-        visit_slots(Clear());
+        Clear clear_slots;
+        visit_slots(clear_slots);
         
         m_occupied_slots.clear();
         m_free_slot_ids.clear();
         m_size = 0;
     }
+
+    template<class TPolicy, class... Args>
+    void ItemPoolTuple_<TPolicy, Args...>::reset()
+    {
+        m_occupied_slots.truncate(0);
+        m_free_slot_ids.clear();
+        m_size = 0;
+    }
     
-    template<class... Args>
-    typename ItemPoolTuple<Args...>::size_type ItemPoolTuple<Args...>::size() const
+    template<class TPolicy, class... Args>
+    typename ItemPoolTuple_<TPolicy, Args...>::size_type ItemPoolTuple_<TPolicy, Args...>::size() const
     {
         return m_size;
     }
@@ -89,82 +106,229 @@ namespace do_ast {
         }
     };
 
-    template<class... Args>
-    ItemPoolIndex ItemPoolTuple<Args...>::insert()
+    struct AssignDefault
+    {
+        std::size_t index;
+
+        template<std::size_t Idx, class T>
+        void visit(T& slots)
+        {
+            assign_slot(slots, index, typename T::value_type());
+        }
+    };
+
+    template<class TPolicy, class... Args>
+    typename ItemPoolTuple_<TPolicy, Args...>::Index ItemPoolTuple_<TPolicy, Args...>::insert()
     {
         if (m_free_slot_ids.size() > 0)
         {
-            ItemPoolIndex new_idx;
-            new_idx.index = m_free_slot_ids.back().index;
-            m_slot_smcs[new_idx.index]++;
+            Index new_idx;
+            new_idx.index = m_free_slot_ids.pop().index;
+            bump_smc(new_idx.index);
             new_idx.smc = m_slot_smcs[new_idx.index];
             ++m_size;
-            m_free_slot_ids.pop_back();
-            m_occupied_slots[new_idx.index] = true;
+            m_occupied_slots.set(new_idx.index);
             return new_idx;
         }
         else
         {
-            ItemPoolIndex new_idx;
-            new_idx.index = m_size;
-            new_idx.smc = 1;
+            Index new_idx;
+            assert(m_occupied_slots.size() <= IndexTraits::max_index());
+            new_idx.index = m_occupied_slots.size();
+            new_idx.smc = fresh_slot_smc(new_idx.index);
             ++m_size;
 
-            visit_slots(EmplaceBack());
+            if (new_idx.index < num_constructed_slots())
+            {
+                AssignDefault assign_default{new_idx.index};
+                visit_slots(assign_default);
+            }
+            else
+            {
+                EmplaceBack emplace_back;
+                visit_slots(emplace_back);
+            }
 
-            m_slot_smcs.emplace_back(new_idx.smc);
             m_occupied_slots.push_back(true);
             return new_idx;
         }
     }
     
-    template<class... Args>
-    struct Assign
+    template<class TPolicy, class... Args>
+    template<class... Values>
+    typename ItemPoolTuple_<TPolicy, Args...>::Index ItemPoolTuple_<TPolicy, Args...>::insert(Values&&... values)
     {
-        using tuple_type = std::tuple<Args...>;
-        tuple_type values_tuple;
-        ItemPoolIndex new_idx;
-
-        template<std::size_t Idx, class T>
-        void visit(T& slots)
+        static_assert(sizeof...(Values) == sizeof...(Args), "insert needs one value per column.");
+        if (m_free_slot_ids.size() > 0)
         {
-            slots[new_idx.index] = std::get<Idx>(values_tuple);
+            Index new_idx = insert();
+            assign_columns(new_idx.index, std::index_sequence_for<Args...>(), std::forward<Values>(values)...);
+            return new_idx;
         }
-    };
-
-    template<class... Args>
-    ItemPoolIndex ItemPoolTuple<Args...>::insert(Args... values)
-    {
-        // ItemPoolIndex new_idx = insert();
+        else
+        {
+            Index new_idx;
+            assert(m_occupied_slots.size() <= IndexTraits::max_index());
+            new_idx.index = m_occupied_slots.size();
+            new_idx.smc = fresh_slot_smc(new_idx.index);
+            ++m_size;
 
+            if (new_idx.index < num_constructed_slots())
+            {
+                assign_columns(new_idx.index, std::index_sequence_for<Args...>(), std::forward<Values>(values)...);
+            }
+            else
+            {
+                emplace_back_columns(std::index_sequence_for<Args...>(), std::forward<Values>(values)...);
+            }
 
-        // tuple_type values_tuple = std::make_tuple(values...);
+            m_occupied_slots.push_back(true);
+            return new_idx;
+        }
+    }
 
+    template<class TPolicy, class... Args>
+    template<std::size_t... Is, class... Values>
+    void ItemPoolTuple_<TPolicy, Args...>::emplace_back_columns(std::index_sequence<Is...>, Values&&... values)
+    {
+        int expand[] = {0, (std::get<Is>(m_slots).emplace_back(std::forward<Values>(values)), 0)...};
+        (void)expand;
+    }
 
-        Assign<Args...> assign;
-        assign.values_tuple = std::make_tuple(values...);
-        assign.new_idx = insert();
-        visit_slots(assign);
+    template<class TPolicy, class... Args>
+    template<std::size_t... Is, class... Values>
+    void ItemPoolTuple_<TPolicy, Args...>::assign_columns(std::size_t index, std::index_sequence<Is...>, Values&&... values)
+    {
+        int expand[] = {0, (assign_slot(std::get<Is>(m_slots), index, std::forward<Values>(values)), 0)...};
+        (void)expand;
+    }
 
-        // m_slots[new_idx.index] = value;
-        return assign.new_idx;
+    template<class TPolicy, class... Args>
+    template<std::size_t... Is>
+    std::size_t ItemPoolTuple_<TPolicy, Args...>::columns_bytes(std::index_sequence<Is...>) const
+    {
+        std::size_t bytes = 0;
+        int expand[] = {0, (bytes += column_bytes(std::get<Is>(m_slots)), 0)...};
+        (void)expand;
+        return bytes;
     }
     
-    template<class... Args>
-    void ItemPoolTuple<Args...>::erase(ItemPoolIndex idx)
+    template<class TPolicy, class... Args>
+    void ItemPoolTuple_<TPolicy, Args...>::erase(Index idx)
     {
-        if (!m_occupied_slots[idx.index]) return;
-        m_slot_smcs[idx.index]++;
-        m_occupied_slots[idx.index] = false;
-        m_free_slot_ids.push_back(idx);
+        // stale handles, also those from before a reset, are ignored
+        if (!contains(idx)) return;
+        bump_smc(idx.index);
+        m_occupied_slots.reset(idx.index);
+        m_free_slot_ids.push(idx);
         --m_size;
     }
     
-    template<class... Args>
-    bool ItemPoolTuple<Args...>::contains(ItemPoolIndex idx) const
+    template<class TPolicy, class... Args>
+    bool ItemPoolTuple_<TPolicy, Args...>::contains(Index idx) const
     {
         // return m_occupied_slots[idx.index] && (m_slot_smcs[idx.index] == idx.smc);
-        return (m_slot_smcs[idx.index] == idx.smc);
+        return (idx.index < m_occupied_slots.size()) && (m_slot_smcs[idx.index] == idx.smc);
+    }
+
+    template<class TPolicy, class... Args>
+    template<class Callback>
+    void ItemPoolTuple_<TPolicy, Args...>::for_each_live(Callback callback) const
+    {
+        m_occupied_slots.for_each_set([this, &callback](std::size_t i) {
+            callback(Index{i, m_slot_smcs[i]});
+        });
+    }
+
+    template<class TPolicy, class... Args>
+    template<std::size_t K, class Callback>
+    void ItemPoolTuple_<TPolicy, Args...>::for_each_live(Callback callback)
+    {
+        auto& column = std::get<K>(m_slots);
+        m_occupied_slots.for_each_set([this, &column, &callback](std::size_t i) {
+            callback(Index{i, m_slot_smcs[i]}, column[i]);
+        });
+    }
+
+    template<class TPolicy, class... Args>
+    template<std::size_t K, class Callback>
+    void ItemPoolTuple_<TPolicy, Args...>::for_each_live(Callback callback) const
+    {
+        const auto& column = std::get<K>(m_slots);
+        m_occupied_slots.for_each_set([this, &column, &callback](std::size_t i) {
+            callback(Index{i, m_slot_smcs[i]}, column[i]);
+        });
+    }
+
+    template<class TPolicy, class... Args>
+    uint32_t ItemPoolTuple_<TPolicy, Args...>::fresh_slot_smc(std::size_t index)
+    {
+        // slots released by compact() or clear() keep their smc, continue counting from there
+        if (index < m_slot_smcs.size())
+        {
+            bump_smc(index);
+            return m_slot_smcs[index];
+        }
+        m_slot_smcs.push_back(1);
+        return 1;
+    }
+
+    struct MoveSlot
+    {
+        std::size_t src;
+        std::size_t dst;
+
+        template<std::size_t Idx, class T>
+        void visit(T& slots)
+        {
+            move_slot(slots, src, dst);
+        }
+    };
+
+    struct Truncate
+    {
+        std::size_t size;
+
+        template<std::size_t Idx, class T>
+        void visit(T& slots)
+        {
+            slots.resize(size);
+            slots.shrink_to_fit();
+        }
+    };
+
+    template<class TPolicy, class... Args>
+    typename ItemPoolTuple_<TPolicy, Args...>::Remap ItemPoolTuple_<TPolicy, Args...>::compact()
+    {
+        Remap remap;
+        auto num_slots = m_occupied_slots.size();
+        remap.new_index.resize(num_slots);
+        remap.old_smcs.assign(m_slot_smcs.begin(), m_slot_smcs.begin() + num_slots);
+
+        std::size_t num_live = 0;
+        for (std::size_t src = 0; src < num_slots; ++src)
+        {
+            if (!m_occupied_slots[src]) continue;
+            auto dst = num_live++;
+            if (dst != src)
+            {
+                // dst is a free slot, its smc is already newer than any handle to it
+                MoveSlot move_slot{src, dst};
+                visit_slots(move_slot);
+                bump_smc(dst);
+                bump_smc(src);
+            }
+            remap.new_index[src] = Index{dst, m_slot_smcs[dst]};
+        }
+
+        Truncate truncate{num_live};
+        visit_slots(truncate);
+        m_occupied_slots.assign(num_live, true);
+        m_occupied_slots.shrink_to_fit();
+        m_free_slot_ids.clear();
+        m_free_slot_ids.shrink_to_fit();
+        m_size = num_live;
+        return remap;
     }
 
     template<class tuple_type_>
@@ -176,7 +340,7 @@ namespace do_ast {
         template<class Visitor, std::size_t Idx=0, std::enable_if_t<(Idx < num_types::value), bool> = true>
         void visit(Visitor& visitor, tuple_type& tuple)
         {
-            visitor.visit<Idx>(std::get<Idx>(tuple));
+            visitor.template visit<Idx>(std::get<Idx>(tuple));
             visit<Visitor,Idx+1>(visitor, tuple);
         };
         template<class Visitor, std::size_t Idx=0, std::enable_if_t<(Idx >= num_types::value), bool> = true>
@@ -188,13 +352,13 @@ namespace do_ast {
     template<class... Args>
     using TupleVisitor_ = TupleVisitor<std::tuple<Args...>>;
 
-    template<class... Args>
+    template<class TPolicy, class... Args>
     template<class SlotsVisitor>
-    void ItemPoolTuple<Args...>::visit_slots(SlotsVisitor& slots_visitor)
+    void ItemPoolTuple_<TPolicy, Args...>::visit_slots(SlotsVisitor& slots_visitor)
     {
         TupleVisitor<tuple_type> tuple_visitor;
 
-        tuple_visitor.visit<SlotsVisitor>(slots_visitor, m_slots);
+        tuple_visitor.template visit<SlotsVisitor>(slots_visitor, m_slots);
     }
 
 
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <do_ast/arena_allocator.h>
+
+namespace do_ast {
+
+    // marks a cold column of ItemPoolTuple_: ItemPoolTuple_<Policy, Type, Lazy<Value>>.
+    // only slots with a non-empty value store it, in a side table keyed by the slot.
+    // const access to a slot without value returns the empty value, non-const access materializes it.
+    template<class T>
+    struct Lazy
+    {
+        using value_type = T;
+    };
+
+    // decides which values a lazy column leaves out, specialize for types without operator==
+    template<class T, class = void>
+    struct LazyTraits
+    {
+        static bool is_empty(const T& value) { return value == T(); }
+    };
+
+    template<class T, class TAllocator = std::allocator<T>>
+    struct LazyColumn
+    {
+        // per slot id into a dense value table, NoValue for slots holding the empty value.
+        // value ids of released values are reused.
+        using value_type = T;
+        using size_type = std::size_t;
+        using allocator_type = TAllocator;
+        using ValueId = uint32_t;
+        using NoValue = std::integral_constant<ValueId, UINT32_MAX>;
+        template<class U> using vector_type = std::vector<U, rebind_alloc_t<TAllocator, U>>;
+
+        LazyColumn() = default;
+        explicit LazyColumn(const allocator_type& alloc)
+        : m_value_ids(alloc)
+        , m_values(alloc)
+        , m_free_value_ids(alloc)
+        {}
+
+        size_type size() const { return m_value_ids.size(); }
+        bool empty() const { return m_value_ids.empty(); }
+        // number of stored values
+        size_type num_values() const { return m_values.size() - m_free_value_ids.size(); }
+        bool has_value(size_type i) const { return m_value_ids[i] != NoValue::value; }
+
+        const T& operator[](size_type i) const
+        {
+            auto id = m_value_ids[i];
+            return (id != NoValue::value) ? m_values[id] : empty_value();
+        }
+        T& operator[](size_type i) { return materialize(i); }
+
+        const T& at(size_type i) const
+        {
+            if (i >= size()) throw std::out_of_range("LazyColumn::at");
+            return (*this)[i];
+        }
+        T& at(size_type i)
+        {
+            if (i >= size()) throw std::out_of_range("LazyColumn::at");
+            return (*this)[i];
+        }
+
+        void emplace_back() { m_value_ids.push_back(NoValue::value); }
+        template<class V> void emplace_back(V&& value)
+        {
+            m_value_ids.push_back(NoValue::value);
+            set(size() - 1, std::forward<V>(value));
+        }
+
+        template<class V> void set(size_type i, V&& value)
+        {
+            if (LazyTraits<T>::is_empty(value))
+            {
+                release(i);
+            }
+            else
+            {
+                materialize(i) = std::forward<V>(value);
+            }
+        }
+
+        // moves the value of src to dst, src is left empty
+        void move_slot(size_type src, size_type dst)
+        {
+            release(dst);
+            m_value_ids[dst] = m_value_ids[src];
+            m_value_ids[src] = NoValue::value;
+        }
+
+        void resize(size_type new_size)
+        {
+            for (auto i = new_size; i < size(); ++i) release(i);
+            m_value_ids.resize(new_size, NoValue::value);
+        }
+
+        void reserve(size_type capacity) { m_value_ids.reserve(capacity); }
+
+        void clear()
+        {
+            m_value_ids.clear();
+            m_values.clear();
+            m_free_value_ids.clear();
+        }
+
+        void shrink_to_fit()
+        {
+            m_value_ids.shrink_to_fit();
+            m_values.shrink_to_fit();
+            m_free_value_ids.shrink_to_fit();
+        }
+
+        // allocated bytes of the id column and the value table
+        size_type capacity_bytes() const
+        {
+            return m_value_ids.capacity() * sizeof(ValueId) + m_values.capacity() * sizeof(T) + m_free_value_ids.capacity() * sizeof(ValueId);
+        }
+
+        static const T& empty_value()
+        {
+            static const T value{};
+            return value;
+        }
+
+    protected:
+        T& materialize(size_type i)
+        {
+            auto& id = m_value_ids[i];
+            if (id == NoValue::value)
+            {
+                if (m_free_value_ids.empty())
+                {
+                    id = static_cast<ValueId>(m_values.size());
+                    m_values.emplace_back();
+                }
+                else
+                {
+                    id = m_free_value_ids.back();
+                    m_free_value_ids.pop_back();
+                }
+            }
+            return m_values[id];
+        }
+
+        void release(size_type i)
+        {
+            auto& id = m_value_ids[i];
+            if (id == NoValue::value) return;
+            m_values[id] = T(); // drops owned payloads such as strings
+            m_free_value_ids.push_back(id);
+            id = NoValue::value;
+        }
+
+        vector_type<ValueId> m_value_ids;
+        vector_type<T> m_values;
+        vector_type<ValueId> m_free_value_ids;
+    };
+
+    // maps a column declaration of ItemPoolTuple_ to the item type and the container of the column
+    template<class T>
+    struct ColumnTraits
+    {
+        using value_type = T;
+        template<class TStorage> using slots_type = typename TStorage::template slots_type<T>;
+    };
+
+    template<class T>
+    struct ColumnTraits<Lazy<T>>
+    {
+        using value_type = T;
+        template<class TStorage> using slots_type = LazyColumn<T, rebind_alloc_t<typename TStorage::allocator_type, T>>;
+    };
+
+    template<class T>
+    using column_value_t = typename ColumnTraits<T>::value_type;
+
+    // slot operations of ItemPoolTuple_, overloaded for lazy columns so they do not materialize empty values
+
+    template<class TSlots, class V>
+    void assign_slot(TSlots& slots, std::size_t index, V&& value)
+    {
+        slots[index] = std::forward<V>(value);
+    }
+
+    template<class T, class TAllocator, class V>
+    void assign_slot(LazyColumn<T, TAllocator>& slots, std::size_t index, V&& value)
+    {
+        slots.set(index, std::forward<V>(value));
+    }
+
+    template<class TSlots>
+    void move_slot(TSlots& slots, std::size_t src, std::size_t dst)
+    {
+        slots[dst] = std::move(slots[src]);
+    }
+
+    template<class T, class TAllocator>
+    void move_slot(LazyColumn<T, TAllocator>& slots, std::size_t src, std::size_t dst)
+    {
+        slots.move_slot(src, dst);
+    }
+
+    template<class TSlots>
+    std::size_t column_bytes(const TSlots& slots)
+    {
+        return slots.capacity() * sizeof(typename TSlots::value_type);
+    }
+
+    template<class T, class TAllocator>
+    std::size_t column_bytes(const LazyColumn<T, TAllocator>& slots)
+    {
+        return slots.capacity_bytes();
+    }
+
+} // namespace do_ast
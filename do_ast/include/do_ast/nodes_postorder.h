@@ -6,6 +6,7 @@
 #include <type_traits>
 
 #include <do_ast/type_value.h>
+#include <do_ast/arena_allocator.h>
 
 namespace do_ast {
 
@@ -14,7 +15,8 @@ namespace do_ast {
         class TNode = TypeValue<>, 
         class TNodeId = int64_t, 
         class TDepth = uint32_t, 
-        class TSize = int64_t
+        class TSize = int64_t,
+        class TAllocator = std::allocator<TNode>
     >
     struct NodesPostorder
     {
@@ -35,25 +37,41 @@ namespace do_ast {
         using NodeId = TNodeId;
         using Depth = TDepth;
         using Size = TSize;
+        using allocator_type = TAllocator;
+        template<class T> using vector_type = std::vector<T, rebind_alloc_t<TAllocator, T>>;
 
         // minimum information necessary
-        std::vector<Node> postorder;
-        std::vector<Size> num_args;
+        vector_type<Node> postorder;
+        vector_type<Size> num_args;
 
         // pointers allowing traversal in any direction
-        std::vector<NodeId> up;
-        std::vector<NodeId> down;
-        std::vector<NodeId> prev;
-        std::vector<NodeId> next;
+        vector_type<NodeId> up;
+        vector_type<NodeId> down;
+        vector_type<NodeId> prev;
+        vector_type<NodeId> next;
 
         // preorder related
-        std::vector<Depth> depth;
-        std::vector<NodeId> preorder;
-        std::vector<NodeId> next_preorder;
-        std::vector<NodeId> skip_preorder; 
+        vector_type<Depth> depth;
+        vector_type<NodeId> preorder;
+        vector_type<NodeId> next_preorder;
+        vector_type<NodeId> skip_preorder; 
 
         // std::vector<NodeId> next_or_up;
         
+        NodesPostorder() = default;
+        explicit NodesPostorder(const allocator_type& alloc)
+        : postorder(alloc)
+        , num_args(alloc)
+        , up(alloc)
+        , down(alloc)
+        , prev(alloc)
+        , next(alloc)
+        , depth(alloc)
+        , preorder(alloc)
+        , next_preorder(alloc)
+        , skip_preorder(alloc)
+        {}
+
         void clear()
         {
             postorder.clear();
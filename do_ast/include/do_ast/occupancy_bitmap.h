@@ -0,0 +1,189 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+#include <algorithm>
+
+#include <do_ast/bit_ops.h>
+#include <do_ast/arena_allocator.h>
+
+namespace do_ast {
+
+    template<class TAllocator = std::allocator<uint64_t>>
+    struct OccupancyBitmap_
+    {
+        // one bit per slot packed into 64 bit words.
+        // bits past size() are always zero in the words in use, so whole words can be scanned without masking.
+        // truncate() keeps the words past the new size without clearing them, they are zeroed when they are used again.
+
+        using Word = uint64_t;
+        using WordBits = std::integral_constant<std::size_t, 64>;
+        using allocator_type = TAllocator;
+        using words_type = std::vector<Word, rebind_alloc_t<TAllocator, Word>>;
+
+        OccupancyBitmap_() = default;
+        explicit OccupancyBitmap_(const allocator_type& alloc) : m_words(alloc) {}
+
+        bool operator[](std::size_t i) const { return test(i); }
+        bool test(std::size_t i) const { return (m_words[i / WordBits::value] >> (i % WordBits::value)) & 1; }
+        void set(std::size_t i)   { m_words[i / WordBits::value] |=  (Word(1) << (i % WordBits::value)); }
+        void reset(std::size_t i) { m_words[i / WordBits::value] &= ~(Word(1) << (i % WordBits::value)); }
+
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        std::size_t num_words() const { return words_for(m_size); }
+        const Word* words() const { return m_words.data(); }
+
+        void push_back(bool value)
+        {
+            if (m_size % WordBits::value == 0) use_words(m_size / WordBits::value + 1);
+            if (value) set(m_size);
+            ++m_size;
+        }
+
+        void resize(std::size_t new_size, bool value = false)
+        {
+            auto old_size = m_size;
+            if (new_size > old_size) use_words(words_for(new_size));
+            m_size = new_size;
+            if (new_size < old_size)
+            {
+                clear_tail();
+            }
+            else if (value)
+            {
+                // bits up to the next word boundary one by one, then whole words
+                auto i = old_size;
+                for (; (i < new_size) && (i % WordBits::value != 0); ++i) set(i);
+                if (i < new_size)
+                {
+                    std::fill(m_words.begin() + i / WordBits::value, m_words.begin() + words_for(new_size), ~Word(0));
+                    clear_tail();
+                }
+            }
+        }
+
+        void assign(std::size_t new_size, bool value)
+        {
+            m_words.assign(words_for(new_size), value ? ~Word(0) : Word(0));
+            m_size = new_size;
+            clear_tail();
+        }
+
+        void reserve(std::size_t capacity) { m_words.reserve(words_for(capacity)); }
+        void clear() { m_words.clear(); m_size = 0; }
+        void shrink_to_fit() { m_words.resize(num_words()); m_words.shrink_to_fit(); }
+
+        // O(1) shrink, the words past new_size stay allocated for reuse
+        void truncate(std::size_t new_size)
+        {
+            if (new_size >= m_size) return;
+            m_size = new_size;
+            clear_tail();
+        }
+
+        // number of set bits
+        std::size_t count() const
+        {
+            std::size_t result = 0;
+            const auto num = num_words();
+            for (std::size_t w = 0; w < num; ++w) result += count_ones(m_words[w]);
+            return result;
+        }
+
+        // calls callback(index) for each set bit in ascending order, skipping zero words in bulk
+        template<class Callback>
+        void for_each_set(Callback callback) const
+        {
+            const auto num = num_words();
+            for (std::size_t w = 0; w < num; ++w)
+            {
+                Word word = m_words[w];
+                while (word != 0)
+                {
+                    callback(w * WordBits::value + count_trailing_zeros(word));
+                    word &= word - 1;
+                }
+            }
+        }
+
+        struct SetBitIterator
+        {
+            const Word* words = nullptr;
+            std::size_t num_words = 0;
+            std::size_t word_idx = 0;
+            Word word = 0;
+
+            SetBitIterator() = default;
+            SetBitIterator(const Word* words, std::size_t num_words, std::size_t word_idx)
+            : words(words), num_words(num_words), word_idx(word_idx)
+            {
+                word = (word_idx < num_words) ? words[word_idx] : 0;
+                skip_zero_words();
+            }
+
+            std::size_t operator*() const { return word_idx * WordBits::value + count_trailing_zeros(word); }
+            SetBitIterator& operator++()
+            {
+                word &= word - 1;
+                skip_zero_words();
+                return *this;
+            }
+            bool operator==(const SetBitIterator& other) const { return (word_idx == other.word_idx) && (word == other.word); }
+            bool operator!=(const SetBitIterator& other) const { return !(*this == other); }
+
+        protected:
+            void skip_zero_words()
+            {
+                while ((word == 0) && (word_idx < num_words))
+                {
+                    ++word_idx;
+                    word = (word_idx < num_words) ? words[word_idx] : 0;
+                }
+            }
+        };
+
+        struct SetBits
+        {
+            SetBitIterator first;
+            SetBitIterator last;
+            SetBitIterator begin() const { return first; }
+            SetBitIterator end() const { return last; }
+        };
+
+        // range over the indices of all set bits
+        SetBits set_bits() const
+        {
+            return SetBits{
+                SetBitIterator(m_words.data(), num_words(), 0),
+                SetBitIterator(m_words.data(), num_words(), num_words())
+            };
+        }
+
+    protected:
+        static std::size_t words_for(std::size_t size) { return (size + WordBits::value - 1) / WordBits::value; }
+
+        void clear_tail()
+        {
+            auto tail = m_size % WordBits::value;
+            if (tail != 0) m_words[m_size / WordBits::value] &= (Word(1) << tail) - 1;
+        }
+
+        // grows the words in use to num, words left over from truncate() are zeroed
+        void use_words(std::size_t num)
+        {
+            auto num_used = num_words();
+            auto num_kept = std::min(num, m_words.size());
+            if (num_kept > num_used) std::fill(m_words.begin() + num_used, m_words.begin() + num_kept, Word(0));
+            if (num > m_words.size()) m_words.resize(num, 0);
+        }
+
+        words_type m_words;
+        std::size_t m_size = 0;
+    };
+
+    using OccupancyBitmap = OccupancyBitmap_<>;
+
+} // namespace do_ast
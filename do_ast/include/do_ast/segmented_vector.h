@@ -0,0 +1,177 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+#include <do_ast/arena_allocator.h>
+
+namespace do_ast {
+
+    template<class T, std::size_t TSegmentSize = 4096, class TAllocator = std::allocator<T>>
+    struct SegmentedVector
+    {
+        // vector-like container storing its items in fixed size segments.
+        // the segments are reached through a small directory of segment pointers.
+        // growth allocates a new segment and never moves existing items,
+        // so references to items stay valid until the item is removed.
+        // items are not contiguous, there is no data().
+
+        static_assert((TSegmentSize > 0) && ((TSegmentSize & (TSegmentSize - 1)) == 0), "TSegmentSize must be a power of two.");
+
+        using value_type = T;
+        using size_type = std::size_t;
+        using allocator_type = TAllocator;
+        using SegmentSize = std::integral_constant<std::size_t, TSegmentSize>;
+
+        SegmentedVector() = default;
+        explicit SegmentedVector(const allocator_type& alloc)
+        : m_segments(alloc), m_allocator(alloc)
+        {}
+        SegmentedVector(const SegmentedVector& other)
+        : m_segments(segment_traits::select_on_container_copy_construction(other.m_allocator))
+        , m_allocator(segment_traits::select_on_container_copy_construction(other.m_allocator))
+        { 
+            *this = other; 
+        }
+        SegmentedVector(SegmentedVector&& other)
+        : m_segments(std::move(other.m_segments)), m_allocator(other.m_allocator), m_size(other.m_size)
+        {
+            other.m_segments.clear();
+            other.m_size = 0;
+        }
+        SegmentedVector& operator=(SegmentedVector&& other)
+        {
+            if (this == &other) return *this;
+            clear();
+            release_segments(0);
+            m_segments = std::move(other.m_segments);
+            m_allocator = other.m_allocator;
+            m_size = other.m_size;
+            other.m_segments.clear();
+            other.m_size = 0;
+            return *this;
+        }
+        SegmentedVector& operator=(const SegmentedVector& other)
+        {
+            if (this == &other) return *this;
+            clear();
+            reserve(other.size());
+            for (size_type i = 0; i < other.size(); ++i)
+            {
+                emplace_back(other[i]);
+            }
+            return *this;
+        }
+        ~SegmentedVector() 
+        { 
+            clear(); 
+            release_segments(0);
+        }
+
+        allocator_type get_allocator() const { return allocator_type(m_allocator); }
+
+              T& operator[](size_type i)       { return *ptr(i); }
+        const T& operator[](size_type i) const { return *ptr(i); }
+
+              T& at(size_type i)       { assert(i < m_size); return *ptr(i); }
+        const T& at(size_type i) const { assert(i < m_size); return *ptr(i); }
+
+              T& back()       { return *ptr(m_size - 1); }
+        const T& back() const { return *ptr(m_size - 1); }
+
+        size_type size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        size_type capacity() const { return m_segments.size() * TSegmentSize; }
+
+        template<class... Args>
+        T& emplace_back(Args&&... args)
+        {
+            if (m_size == capacity())
+            {
+                add_segment();
+            }
+            T* item = ptr(m_size);
+            new (item) T(std::forward<Args>(args)...);
+            ++m_size;
+            return *item;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        void pop_back()
+        {
+            --m_size;
+            ptr(m_size)->~T();
+        }
+
+        void reserve(size_type new_capacity)
+        {
+            while (capacity() < new_capacity)
+            {
+                add_segment();
+            }
+        }
+
+        void resize(size_type new_size)
+        {
+            while (m_size > new_size) pop_back();
+            while (m_size < new_size) emplace_back();
+        }
+
+        // destroys all items, keeps the allocated segments
+        void clear()
+        {
+            while (m_size > 0) pop_back();
+        }
+
+        // releases segments not needed for the current size
+        void shrink_to_fit()
+        {
+            auto num_needed = (m_size + TSegmentSize - 1) / TSegmentSize;
+            release_segments(num_needed);
+            m_segments.shrink_to_fit();
+        }
+
+    protected:
+        struct Segment
+        {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type items[TSegmentSize];
+        };
+
+        using segment_allocator_type = rebind_alloc_t<TAllocator, Segment>;
+        using segment_traits = std::allocator_traits<segment_allocator_type>;
+
+        T* ptr(size_type i) const
+        {
+            return reinterpret_cast<T*>(&m_segments[i / TSegmentSize]->items[i % TSegmentSize]);
+        }
+
+        void add_segment()
+        {
+            // grow the directory first, so push_back cannot throw after the segment is allocated
+            if (m_segments.size() == m_segments.capacity()) m_segments.reserve(2 * m_segments.size() + 1);
+            m_segments.push_back(segment_traits::allocate(m_allocator, 1));
+        }
+
+        // returns the segments past num_keep to the allocator
+        void release_segments(std::size_t num_keep)
+        {
+            while (m_segments.size() > num_keep)
+            {
+                segment_traits::deallocate(m_allocator, m_segments.back(), 1);
+                m_segments.pop_back();
+            }
+        }
+
+        std::vector<Segment*, rebind_alloc_t<TAllocator, Segment*>> m_segments;
+        segment_allocator_type m_allocator;
+        size_type m_size = 0;
+    };
+
+} // namespace do_ast
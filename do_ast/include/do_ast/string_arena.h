@@ -0,0 +1,267 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <ostream>
+#include <algorithm>
+#include <type_traits>
+
+#include <do_ast/arena_allocator.h>
+
+namespace do_ast {
+
+    struct StringRef
+    {
+        // non owning view of the bytes of a string, stands in for std::string_view
+        StringRef() = default;
+        StringRef(const char* data, std::size_t size) : m_data(data), m_size(size) {}
+        StringRef(const char* str) : m_data(str), m_size(std::strlen(str)) {}
+        StringRef(const std::string& str) : m_data(str.data()), m_size(str.size()) {}
+
+        const char* data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        const char* begin() const { return m_data; }
+        const char* end() const { return m_data + m_size; }
+        char operator[](std::size_t k) const { return m_data[k]; }
+
+        std::string str() const { return std::string(m_data, m_size); }
+
+        int compare(StringRef other) const
+        {
+            auto n = std::min(m_size, other.m_size);
+            int cmp = (n > 0) ? std::memcmp(m_data, other.m_data, n) : 0;
+            if (cmp != 0) return cmp;
+            return (m_size < other.m_size) ? -1 : ((m_size > other.m_size) ? 1 : 0);
+        }
+
+        friend bool operator==(StringRef a, StringRef b) { return (a.m_size == b.m_size) && (a.compare(b) == 0); }
+        friend bool operator!=(StringRef a, StringRef b) { return !(a == b); }
+        friend bool operator<(StringRef a, StringRef b) { return a.compare(b) < 0; }
+
+        friend std::ostream& operator<<(std::ostream& os, StringRef str)
+        {
+            return os.write(str.m_data, static_cast<std::streamsize>(str.m_size));
+        }
+
+    protected:
+        const char* m_data = "";
+        std::size_t m_size = 0;
+    };
+
+    template<class TAllocator = std::allocator<char>>
+    struct StringArena_
+    {
+        // stores every distinct string once and names it by a Symbol, equal strings get equal symbols.
+        // the bytes are appended to chunks which are never reallocated, so the StringRef of a symbol
+        // stays valid until clear or reset. strings are not erased one by one.
+        using allocator_type = TAllocator;
+        using Symbol = uint32_t;
+        using NoSymbol = std::integral_constant<Symbol, UINT32_MAX>;
+        template<class U> using vector_type = std::vector<U, rebind_alloc_t<TAllocator, U>>;
+
+        StringArena_() = default;
+        explicit StringArena_(const allocator_type& alloc)
+        : m_entries(alloc)
+        , m_table(alloc)
+        , m_chunks(alloc)
+        {}
+
+        // a copy stores the strings again in chunks of its own, the symbols stay the same.
+        // a move keeps the chunks, the stored strings do not move.
+        StringArena_(const StringArena_& other)
+        : StringArena_(other.get_allocator())
+        {
+            copy_strings(other);
+        }
+
+        StringArena_& operator=(const StringArena_& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                copy_strings(other);
+            }
+            return *this;
+        }
+
+        StringArena_(StringArena_&&) = default;
+        StringArena_& operator=(StringArena_&&) = default;
+
+        // symbol of str, adds a copy of str if it is not yet stored
+        Symbol intern(StringRef str)
+        {
+            auto hash = hash_bytes(str);
+            if (2 * (m_entries.size() + 1) > m_table.size()) grow_table();
+            auto mask = m_table.size() - 1;
+            for (auto slot = hash & mask; ; slot = (slot + 1) & mask)
+            {
+                auto symbol = m_table[slot];
+                if (symbol == NoSymbol::value)
+                {
+                    assert(m_entries.size() < NoSymbol::value);
+                    symbol = static_cast<Symbol>(m_entries.size());
+                    m_entries.push_back(Entry{store(str), static_cast<uint32_t>(str.size()), hash});
+                    m_table[slot] = symbol;
+                    return symbol;
+                }
+                if (matches(m_entries[symbol], str, hash)) return symbol;
+            }
+        }
+
+        // symbol of str, NoSymbol if it is not stored
+        Symbol find(StringRef str) const
+        {
+            if (m_table.empty()) return NoSymbol::value;
+            auto hash = hash_bytes(str);
+            auto mask = m_table.size() - 1;
+            for (auto slot = hash & mask; ; slot = (slot + 1) & mask)
+            {
+                auto symbol = m_table[slot];
+                if ((symbol == NoSymbol::value) || matches(m_entries[symbol], str, hash)) return symbol;
+            }
+        }
+
+        StringRef get(Symbol symbol) const
+        {
+            const auto& entry = m_entries[symbol];
+            return StringRef(entry.data, entry.size);
+        }
+
+        // number of distinct strings
+        std::size_t size() const { return m_entries.size(); }
+        bool empty() const { return m_entries.empty(); }
+
+        // bytes of the stored strings and allocated bytes of chunks, symbols and hash table
+        std::size_t bytes_used() const { return m_bytes_used; }
+        std::size_t bytes_reserved() const
+        {
+            std::size_t bytes = m_entries.capacity() * sizeof(Entry) + m_table.capacity() * sizeof(Symbol) + m_chunks.capacity() * sizeof(Chunk);
+            for (const auto& chunk : m_chunks) bytes += chunk.capacity();
+            return bytes;
+        }
+
+        // drops all strings and frees their chunks
+        void clear()
+        {
+            m_entries.clear();
+            m_table.clear();
+            m_chunks.clear();
+            m_num_used_chunks = 0;
+            m_bytes_used = 0;
+        }
+
+        // drops all strings, keeps the chunks and the hash table for the next strings
+        void reset()
+        {
+            m_entries.clear();
+            std::fill(m_table.begin(), m_table.end(), NoSymbol::value);
+            for (auto& chunk : m_chunks) chunk.clear();
+            m_num_used_chunks = 0;
+            m_bytes_used = 0;
+        }
+
+        allocator_type get_allocator() const { return m_entries.get_allocator(); }
+
+    protected:
+        using Chunk = vector_type<char>;
+        using MinChunkSize = std::integral_constant<std::size_t, 4*1024>;
+        using MaxChunkSize = std::integral_constant<std::size_t, 1024*1024>;
+
+        struct Entry
+        {
+            const char* data;
+            uint32_t size;
+            uint32_t hash;
+        };
+
+        static uint32_t hash_bytes(StringRef str)
+        {
+            // fnv-1a over 8 byte words, the tail byte by byte
+            uint64_t hash = 14695981039346656037ull;
+            const char* ptr = str.data();
+            std::size_t n = str.size();
+            for (; n >= 8; ptr += 8, n -= 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, ptr, 8);
+                hash = (hash ^ word) * 1099511628211ull;
+            }
+            for (; n > 0; ++ptr, --n) hash = (hash ^ static_cast<unsigned char>(*ptr)) * 1099511628211ull;
+            return static_cast<uint32_t>(hash ^ (hash >> 32));
+        }
+
+        static bool matches(const Entry& entry, StringRef str, uint32_t hash)
+        {
+            return (entry.hash == hash) && (entry.size == str.size()) && (std::memcmp(entry.data, str.data(), str.size()) == 0);
+        }
+
+        void grow_table()
+        {
+            // the stored hashes place the symbols without touching their bytes
+            auto size = std::max<std::size_t>(m_table.size() * 2, 16);
+            m_table.assign(size, NoSymbol::value);
+            auto mask = size - 1;
+            for (std::size_t symbol = 0; symbol < m_entries.size(); ++symbol)
+            {
+                auto slot = m_entries[symbol].hash & mask;
+                while (m_table[slot] != NoSymbol::value) slot = (slot + 1) & mask;
+                m_table[slot] = static_cast<Symbol>(symbol);
+            }
+        }
+
+        const char* store(StringRef str)
+        {
+            // the last used chunk takes the string, after reset the emptied chunks are taken in order
+            // before new ones are allocated
+            while ((m_num_used_chunks == 0) || (str.size() > free_bytes(m_chunks[m_num_used_chunks - 1])))
+            {
+                if (m_num_used_chunks < m_chunks.size())
+                {
+                    ++m_num_used_chunks;
+                    continue;
+                }
+                add_chunk(str.size());
+            }
+            auto& chunk = m_chunks[m_num_used_chunks - 1];
+            const char* data = chunk.data() + chunk.size();
+            chunk.insert(chunk.end(), str.begin(), str.end());
+            m_bytes_used += str.size();
+            return data;
+        }
+
+        void copy_strings(const StringArena_& other)
+        {
+            // symbols are handed out in order, interning the strings in symbol order keeps them
+            m_entries.reserve(other.m_entries.size());
+            for (std::size_t symbol = 0; symbol < other.m_entries.size(); ++symbol)
+            {
+                intern(other.get(static_cast<Symbol>(symbol)));
+            }
+        }
+
+                static std::size_t free_bytes(const Chunk& chunk) { return chunk.capacity() - chunk.size(); }
+
+        void add_chunk(std::size_t min_size)
+        {
+            // chunks grow geometrically, long strings get a chunk of their own size
+            auto size = m_chunks.empty() ? MinChunkSize::value : std::min(m_chunks.back().capacity() * 2, MaxChunkSize::value);
+            m_chunks.emplace_back(rebind_alloc_t<TAllocator, char>(m_entries.get_allocator()));
+            m_chunks.back().reserve(std::max(size, min_size));
+            ++m_num_used_chunks;
+        }
+
+        vector_type<Entry> m_entries;
+        // open addressing with linear probing, NoSymbol marks a free slot
+        vector_type<Symbol> m_table;
+        vector_type<Chunk> m_chunks;
+        std::size_t m_num_used_chunks = 0;
+        std::size_t m_bytes_used = 0;
+    };
+
+    using StringArena = StringArena_<>;
+
+} // namespace do_ast
@@ -3,6 +3,7 @@
 
 #include <do_ast/v1_ast.h>
 #include <do_ast/v1_tree_printer_visitor.h>
+#include <do_ast/v1_walker.h>
 
 namespace do_ast {
 
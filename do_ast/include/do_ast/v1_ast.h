@@ -7,30 +7,121 @@
 #include <ios>
 #include <iomanip>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <cassert>
 #include <do_ast/item_pool.h>
+#include <do_ast/string_arena.h>
 
 namespace do_ast {
 namespace v1 {
 
-    struct Expression
+    template<class TIndex>
+    struct Expression_
     {
+        using Index = TIndex;
 
-        ItemPoolIndex arg_idx{};
+        union
+        {
+            Index arg_idx{};
+            // scalar value of a WithValue expression, stored inline instead of in a value pool
+            void* value_voidptr;
+            bool value_bool;
+            int8_t value_int8;
+            uint8_t value_uint8;
+            int16_t value_int16;
+            uint16_t value_uint16;
+            int32_t value_int32;
+            uint32_t value_uint32;
+            int64_t value_int64;
+            uint64_t value_uint64;
+            float value_float;
+            double value_double;
+            // symbol of a WithValue<std::string> expression in the string arena of the ast
+            uint32_t value_symbol;
+        };
         uint32_t expr_type = 0;
         uint32_t arg_type = 0;
 
-        Expression() 
+        Expression_() 
         {}
 
-        Expression(uint32_t expr_type, uint32_t arg_type=0, ItemPoolIndex arg_idx = ItemPoolIndex()) 
+        Expression_(uint32_t expr_type, uint32_t arg_type=0, Index arg_idx = Index()) 
         :arg_idx(arg_idx)
         ,expr_type(expr_type)
         ,arg_type(arg_type)
         {}
     };
 
-    template<uint32_t N>
-    using ArgExpressionList = std::array<ItemPoolIndex, N>;
+    using Expression = Expression_<ItemPoolIndex>;
+
+    // value types stored inline in Expression_, the others go to a value pool of the ast
+    template<class T> struct ExpressionValue : public std::false_type {};
+    template<> struct ExpressionValue<void*>    : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_voidptr; } };
+    template<> struct ExpressionValue<bool>     : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_bool; } };
+    template<> struct ExpressionValue<int8_t>   : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_int8; } };
+    template<> struct ExpressionValue<uint8_t>  : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_uint8; } };
+    template<> struct ExpressionValue<int16_t>  : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_int16; } };
+    template<> struct ExpressionValue<uint16_t> : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_uint16; } };
+    template<> struct ExpressionValue<int32_t>  : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_int32; } };
+    template<> struct ExpressionValue<uint32_t> : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_uint32; } };
+    template<> struct ExpressionValue<int64_t>  : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_int64; } };
+    template<> struct ExpressionValue<uint64_t> : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_uint64; } };
+    template<> struct ExpressionValue<float>    : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_float; } };
+    template<> struct ExpressionValue<double>   : public std::true_type { template<class E> static auto& get(E& expr) { return expr.value_double; } };
+
+    template<uint32_t N, class TIndex = ItemPoolIndex>
+    using ArgExpressionList = std::array<TIndex, N>;
+
+    template<class TIndex>
+    struct ArgRange_
+    {
+        // contiguous arguments of an expression: their handles, valid until the next create,
+        // or in Ast_::fold their results
+        using Index = TIndex;
+
+        const Index* first = nullptr;
+        const Index* last = nullptr;
+
+        const Index* begin() const { return first; }
+        const Index* end() const { return last; }
+        std::size_t size() const { return static_cast<std::size_t>(last - first); }
+        bool empty() const { return first == last; }
+        const Index& operator[](std::size_t k) const { return first[k]; }
+    };
+
+    using ArgRange = ArgRange_<ItemPoolIndex>;
+
+    template<class R, class TIndex = ItemPoolIndex, class TAllocator = std::allocator<R>>
+    struct FoldContext_
+    {
+        // buffers of Ast_::fold, reused between folds so only the first folds allocate.
+        // frames holds the open expressions along one path, results the finished arguments of
+        // those expressions, both are bounded by the height of the tree.
+        static_assert(!std::is_same<R, bool>::value, "std::vector<bool> has no contiguous storage, fold into uint8_t.");
+
+        using Index = TIndex;
+        using allocator_type = TAllocator;
+        template<class U> using vector_type = std::vector<U, rebind_alloc_t<TAllocator, U>>;
+
+        struct Frame
+        {
+            const Index* next_arg;
+            const Index* last_arg;
+            std::size_t first_result;
+            Index expr_idx;
+            const Expression_<Index>* expr;
+        };
+
+        FoldContext_() = default;
+        explicit FoldContext_(const allocator_type& alloc) : frames(alloc), results(alloc) {}
+
+        vector_type<Frame> frames;
+        vector_type<R> results;
+    };
 
     template<class T>
     struct ArgValue
@@ -38,98 +129,361 @@ namespace v1 {
         T value;
 
         ArgValue() = default;
-        ArgValue(T value) : value(value) {}
+        ArgValue(T value) : value(std::move(value)) {}
     };
 
-    struct Ast
+    struct AstArgTypes
     {
-        template<class T> using Pool = ItemPool<T>;
+        // arg_type of an expression: number of arguments, type of the value or WithArgList + number of arguments
+        using NoArgs = std::integral_constant<uint32_t, 0>;
+        template<uint32_t N> using WithArgs = std::integral_constant<uint32_t, N>;
+        template<class T> struct WithValue : public std::integral_constant<uint32_t, 0x80000000> {};
+        using WithArgList = std::integral_constant<uint32_t, 0x40000000>;
+        using MaxArgListSize = std::integral_constant<uint32_t, 0x3FFFFFFF>;
 
+        static bool is_arg_list(uint32_t arg_type) { return (arg_type & 0xC0000000) == WithArgList::value; }
+        static uint32_t arg_list_size(uint32_t arg_type) { return arg_type & MaxArgListSize::value; }
+    };
+    template<> struct AstArgTypes::WithValue<void*>       : public std::integral_constant<uint32_t, 0x80000000 + 1> {};
+    template<> struct AstArgTypes::WithValue<bool>        : public std::integral_constant<uint32_t, 0x80000000 + 2> {};
+    template<> struct AstArgTypes::WithValue<int8_t>      : public std::integral_constant<uint32_t, 0x80000000 + 3> {};
+    template<> struct AstArgTypes::WithValue<uint8_t>     : public std::integral_constant<uint32_t, 0x80000000 + 4> {};
+    template<> struct AstArgTypes::WithValue<int16_t>     : public std::integral_constant<uint32_t, 0x80000000 + 5> {};
+    template<> struct AstArgTypes::WithValue<uint16_t>    : public std::integral_constant<uint32_t, 0x80000000 + 6> {};
+    template<> struct AstArgTypes::WithValue<int32_t>     : public std::integral_constant<uint32_t, 0x80000000 + 7> {};
+    template<> struct AstArgTypes::WithValue<uint32_t>    : public std::integral_constant<uint32_t, 0x80000000 + 8> {};
+    template<> struct AstArgTypes::WithValue<int64_t>     : public std::integral_constant<uint32_t, 0x80000000 + 9> {};
+    template<> struct AstArgTypes::WithValue<uint64_t>    : public std::integral_constant<uint32_t, 0x80000000 + 10> {};
+    template<> struct AstArgTypes::WithValue<float>       : public std::integral_constant<uint32_t, 0x80000000 + 11> {};
+    template<> struct AstArgTypes::WithValue<double>      : public std::integral_constant<uint32_t, 0x80000000 + 12> {};
+    template<> struct AstArgTypes::WithValue<std::string> : public std::integral_constant<uint32_t, 0x80000000 + 13> {};
 
-        struct ArgTypes
-        {
-            using NoArgs = std::integral_constant<uint32_t, 0>;
-            template<uint32_t N> using WithArgs = std::integral_constant<uint32_t, N>;
-            template<class T> struct WithValue : public std::integral_constant<uint32_t, 0x80000000> {};
-            template<> struct WithValue<void*>       : public std::integral_constant<uint32_t, 0x80000000 + 1> {};
-            template<> struct WithValue<bool>        : public std::integral_constant<uint32_t, 0x80000000 + 2> {};
-            template<> struct WithValue<int8_t>      : public std::integral_constant<uint32_t, 0x80000000 + 3> {};
-            template<> struct WithValue<uint8_t>     : public std::integral_constant<uint32_t, 0x80000000 + 4> {};
-            template<> struct WithValue<int16_t>     : public std::integral_constant<uint32_t, 0x80000000 + 5> {};
-            template<> struct WithValue<uint16_t>    : public std::integral_constant<uint32_t, 0x80000000 + 6> {};
-            template<> struct WithValue<int32_t>     : public std::integral_constant<uint32_t, 0x80000000 + 7> {};
-            template<> struct WithValue<uint32_t>    : public std::integral_constant<uint32_t, 0x80000000 + 8> {};
-            template<> struct WithValue<int64_t>     : public std::integral_constant<uint32_t, 0x80000000 + 9> {};
-            template<> struct WithValue<uint64_t>    : public std::integral_constant<uint32_t, 0x80000000 + 10> {};
-            template<> struct WithValue<float>       : public std::integral_constant<uint32_t, 0x80000000 + 11> {};
-            template<> struct WithValue<double>      : public std::integral_constant<uint32_t, 0x80000000 + 12> {};
-            template<> struct WithValue<std::string> : public std::integral_constant<uint32_t, 0x80000000 + 13> {};
-        };
+    template<class TPolicy = ItemPoolPolicy<>>
+    struct Ast_
+    {
+        using Policy = TPolicy;
+        using Index = typename Policy::Index;
+        using Range = ItemPoolRange_<Index>;
+        using Remap = ItemPoolRemap_<Index>;
+        using Expression = Expression_<Index>;
+        template<uint32_t N> using ArgExpressionList = v1::ArgExpressionList<N, Index>;
+        template<class T> using Pool = ItemPool<T, Policy>;
+        using ArgTypes = AstArgTypes;
+        using ArgRange = ArgRange_<Index>;
+        using allocator_type = typename Policy::Storage::allocator_type;
+        using Strings = StringArena_<rebind_alloc_t<allocator_type, char>>;
+        using Symbol = typename Strings::Symbol;
+
+        Ast_() = default;
+        // all pools allocate from alloc, e.g. an ArenaAllocator to release the whole ast at once
+        explicit Ast_(const allocator_type& alloc);
 
         struct Visitor
         {
-            void nil(Ast& ast, ItemPoolIndex expr_idx) {} 
-            void no_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type) {} 
-            void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1) {} 
-            void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2) {} 
-            void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3) {} 
-            void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3, ItemPoolIndex arg4) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, void* value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, bool value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int8_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint8_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int16_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint16_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int32_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint32_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int64_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint64_t value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, float value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, double value) {} 
-            void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, const std::string& value) {} 
+            void nil(Ast_& ast, Index expr_idx) {} 
+            void no_args(Ast_& ast, Index expr_idx, uint32_t expr_type) {} 
+            void with_args(Ast_& ast, Index expr_idx, uint32_t expr_type, Index arg1) {} 
+            void with_args(Ast_& ast, Index expr_idx, uint32_t expr_type, Index arg1, Index arg2) {} 
+            void with_args(Ast_& ast, Index expr_idx, uint32_t expr_type, Index arg1, Index arg2, Index arg3) {} 
+            void with_args(Ast_& ast, Index expr_idx, uint32_t expr_type, Index arg1, Index arg2, Index arg3, Index arg4) {} 
+            void with_arg_list(Ast_& ast, Index expr_idx, uint32_t expr_type, ArgRange args) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, void* value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, bool value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, int8_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, uint8_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, int16_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, uint16_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, int32_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, uint32_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, int64_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, uint64_t value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, float value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, double value) {} 
+            void with_value(Ast_& ast, Index expr_idx, uint32_t expr_type, StringRef value) {} 
         };
 
-        template <class V = Visitor> void visit(V& visitor, ItemPoolIndex expr_idx);
+        template <class V = Visitor> void visit(V& visitor, Index expr_idx);
+
+        template<class R> using FoldContext = FoldContext_<R, Index, rebind_alloc_t<allocator_type, R>>;
+
+        // folds the tree below root bottom up without recursion and returns the result of root.
+        // leaf(expr_idx, expr) gives the R of an expression without arguments, node(expr_idx, expr, results)
+        // the R of an expression from the ArgRange_<R> of its argument results. handles without expression give R().
+        // pass the same ctx to later folds so they do not allocate, callbacks may not fold into ctx.
+        template <class R, class Leaf, class Node> R fold(Index root, Leaf&& leaf, Node&& node, FoldContext<R>& ctx) const;
+        template <class R, class Leaf, class Node> R fold(Index root, Leaf&& leaf, Node&& node) const;
 
-        Expression* get(ItemPoolIndex expr_idx)
+        Expression* get(Index expr_idx)
         {
             return m_expr_pool.contains(expr_idx) ? &m_expr_pool.get(expr_idx) : nullptr;
         }
         
-        const Expression* get(ItemPoolIndex expr_idx) const
+        const Expression* get(Index expr_idx) const
         {
             return m_expr_pool.contains(expr_idx) ? &m_expr_pool.get(expr_idx) : nullptr;
         }
 
-        ItemPoolIndex create(uint32_t expr_type);
-
-        ItemPoolIndex create_with_args(uint32_t expr_type, ItemPoolIndex arg1);
-        ItemPoolIndex create_with_args(uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2);
-        ItemPoolIndex create_with_args(uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3);
-        ItemPoolIndex create_with_args(uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3, ItemPoolIndex arg4);
-
-        ItemPoolIndex create_with_value(uint32_t expr_type);
-        ItemPoolIndex create_with_value(uint32_t expr_type, void* value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, bool value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, int8_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, uint8_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, int16_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, uint16_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, int32_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, uint32_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, int64_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, uint64_t value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, float value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, double value);
-        ItemPoolIndex create_with_value(uint32_t expr_type, std::string value);
-
-        void erase_expr(ItemPoolIndex expr_idx);
-        void erase_expr_recursive(ItemPoolIndex expr_idx);
+        Index create(uint32_t expr_type);
+
+        Index create_with_args(uint32_t expr_type, Index arg1);
+        Index create_with_args(uint32_t expr_type, Index arg1, Index arg2);
+        Index create_with_args(uint32_t expr_type, Index arg1, Index arg2, Index arg3);
+        Index create_with_args(uint32_t expr_type, Index arg1, Index arg2, Index arg3, Index arg4);
+        // any number of arguments, stored as offset and count into the flat child arena.
+        // args may not point into the child arena itself.
+        Index create_with_args(uint32_t expr_type, const Index* args, std::size_t num_args);
+
+        // arguments of an expression with arguments, empty for other expressions
+        ArgRange args(Index expr_idx) const;
+        ArgRange args(const Expression& expr) const
+        {
+            // defined here so traversals can inline it despite the extern template
+            if (ArgTypes::is_arg_list(expr.arg_type))
+            {
+                const Index* first = m_child_args.data() + expr.arg_idx.index;
+                return ArgRange{first, first + ArgTypes::arg_list_size(expr.arg_type)};
+            }
+            switch(expr.arg_type)
+            {
+                case ArgTypes::WithArgs<1>::value: { const auto& list = m_arg_expr_list_1_pool.get(expr.arg_idx); return ArgRange{list.data(), list.data() + 1}; }
+                case ArgTypes::WithArgs<2>::value: { const auto& list = m_arg_expr_list_2_pool.get(expr.arg_idx); return ArgRange{list.data(), list.data() + 2}; }
+                case ArgTypes::WithArgs<3>::value: { const auto& list = m_arg_expr_list_3_pool.get(expr.arg_idx); return ArgRange{list.data(), list.data() + 3}; }
+                case ArgTypes::WithArgs<4>::value: { const auto& list = m_arg_expr_list_4_pool.get(expr.arg_idx); return ArgRange{list.data(), list.data() + 4}; }
+                default: return ArgRange();
+            }
+        }
+
+        // value of a WithValue<T> expression, nullptr for other expressions. strings are read with string_value.
+        template <class T> const T* value(Index expr_idx) const;
+        template <class T> const T* value(const Expression& expr) const;
+
+        // string of a WithValue<std::string> expression, empty for other expressions
+        StringRef string_value(Index expr_idx) const;
+        StringRef string_value(const Expression& expr) const
+        {
+            return (expr.arg_type == ArgTypes::WithValue<std::string>::value) ? m_strings.get(expr.value_symbol) : StringRef();
+        }
+        // symbol of a WithValue<std::string> expression, equal strings have equal symbols.
+        // Strings::NoSymbol for other expressions
+        Symbol symbol(Index expr_idx) const;
+        Symbol symbol(const Expression& expr) const
+        {
+            return (expr.arg_type == ArgTypes::WithValue<std::string>::value) ? expr.value_symbol : Strings::NoSymbol::value;
+        }
+
+        // the strings of all string expressions, each stored once. they stay until clear or reset,
+        // erasing an expression does not erase its string.
+        Strings& strings() { return m_strings; }
+        const Strings& strings() const { return m_strings; }
+
+        Index create_with_value(uint32_t expr_type);
+        Index create_with_value(uint32_t expr_type, void* value);
+        Index create_with_value(uint32_t expr_type, bool value);
+        Index create_with_value(uint32_t expr_type, int8_t value);
+        Index create_with_value(uint32_t expr_type, uint8_t value);
+        Index create_with_value(uint32_t expr_type, int16_t value);
+        Index create_with_value(uint32_t expr_type, uint16_t value);
+        Index create_with_value(uint32_t expr_type, int32_t value);
+        Index create_with_value(uint32_t expr_type, uint32_t value);
+        Index create_with_value(uint32_t expr_type, int64_t value);
+        Index create_with_value(uint32_t expr_type, uint64_t value);
+        Index create_with_value(uint32_t expr_type, float value);
+        Index create_with_value(uint32_t expr_type, double value);
+        Index create_with_value(uint32_t expr_type, StringRef value);
+        // string literals would convert to bool
+        Index create_with_value(uint32_t expr_type, const char* value) { return create_with_value(expr_type, StringRef(value)); }
+        // string expression from a symbol of strings()
+        Index create_with_symbol(uint32_t expr_type, Symbol symbol);
+
+        // creates one value expression per item in [first, last) in a single pass.
+        // the expressions occupy contiguous slots.
+        template <class Iterator> Range create_with_values(uint32_t expr_type, Iterator first, Iterator last);
+
+        void erase_expr(Index expr_idx);
+        void erase_expr_recursive(Index expr_idx);
+
+        // interning: creating an expression equal to an existing one returns the existing handle with one
+        // more reference, the ast becomes a dag. equal means same types and same argument handles or value.
+        // handles passed as arguments are handed over to the expression created with them.
+        // erase_expr and erase_expr_recursive drop one reference and erase an expression with its last,
+        // which also drops the references it holds to its arguments.
+        // create_with_values does not intern.
+        void set_interning(bool enabled);
+        bool is_interning() const { return m_interning; }
+        // references held to an expression, 1 without interning
+        uint32_t ref_count(Index expr_idx) const;
+
+        // number of expressions
+        std::size_t size() const { return m_expr_pool.size(); }
+
+        // garbage collection: frees every expression that is not reachable from the roots, also when
+        // expressions are shared by several parents. handles not reachable from the roots are invalid
+        // once a collection begins. strings stay in the string arena.
+        // collect runs a whole collection and returns the number of freed expressions.
+        std::size_t collect(const Index* roots, std::size_t num_roots);
+        // incremental collection: each collect_step does about budget units of work, marking one expression
+        // or sweeping 64 slots is one unit, and returns true when the collection is done.
+        // the ast may be used between steps, expressions created meanwhile survive the collection.
+        // compact, clear and reset cancel a running collection.
+        void begin_collection(const Index* roots, std::size_t num_roots);
+        bool collect_step(std::size_t budget);
+        bool is_collecting() const { return m_gc_phase != GcPhase::Idle; }
 
         void clear();
+        // O(1) clear of all pools, keeps their capacity for the next build
+        void reset();
+
+        // compacts all pools and rewrites the argument handles stored in the expressions.
+        // the returned remap translates expression handles held outside of the ast.
+        Remap compact();
+
+        // copies the expressions below root in src into this ast and returns the handle of the copy.
+        // a counting pass walks src without recursion and sizes the pools, then the copies fill one
+        // contiguous block of slots in post order. expressions shared within the subtree stay shared.
+        // src may be this ast. the copies are not interned, like create_with_values.
+        Index clone_subtree(const Ast_& src, Index root);
+
+        // binary format: the expressions below the roots, numbered densely in post order and written as
+        // columns: the expressions with their inline values, the argument positions, the root positions
+        // and the strings. expressions shared below the roots stay shared. the format is native, it is read
+        // by an ast with the same Index type on a machine with the same byte order. void* values are
+        // written as they are.
+        void save(std::ostream& os, const Index* roots, std::size_t num_roots) const;
+        // appends the expressions of a stream written by save, roots receives the handles of the saved roots.
+        // each pool grows once and is filled from the columns in one pass, like clone_subtree.
+        // returns false and leaves the ast unchanged if the stream is not a valid ast.
+        bool load(std::istream& is, std::vector<Index>& roots);
     protected:
-        void erase_arg(uint32_t arg_type, ItemPoolIndex arg_idx);
+        struct PostOrderBlock
+        {
+            // expressions in post order, copied with their arguments as positions in exprs.
+            // clone_subtree gathers it from a source ast, save writes it and load reads it,
+            // then fill_block creates the expressions of the block.
+            using NoPosition = std::integral_constant<uint32_t, UINT32_MAX>;
+
+            struct Frame
+            {
+                Index expr_idx;
+                const Expression* expr;
+                ArgRange args;
+                const Index* next_arg;
+                // positions of the finished arguments on results start here
+                std::size_t first_result;
+
+                Frame(Index expr_idx, const Expression* expr, ArgRange args, std::size_t first_result) : expr_idx(expr_idx), expr(expr), args(args), next_arg(args.begin()), first_result(first_result) {}
+            };
+
+            explicit PostOrderBlock(const allocator_type& alloc = allocator_type());
+
+            // empties the block, expressions gathered afterwards are not shared with earlier ones
+            void clear();
+            // appends the expressions below root that are not yet in the block and returns the position of root,
+            // NoPosition if root has no expression
+            uint32_t gather(const Ast_& src, Index root);
+            // counts the argument lists and child args of the expressions
+            void count_args();
+
+            typename Policy::Storage::template container_type<Frame> stack;
+            // arg_idx of expressions with arguments is the offset of their first argument in args
+            typename Policy::Storage::template container_type<Expression> exprs;
+            typename Policy::Storage::template container_type<uint32_t> args;
+            typename Policy::Storage::template container_type<uint32_t> results;
+            // position of each source slot in exprs, valid where stamps holds the current generation.
+            // the stamps are kept apart from the positions, a handle may have less than 32 bits of smc.
+            typename Policy::Storage::template container_type<uint32_t> remap;
+            typename Policy::Storage::template container_type<uint32_t> stamps;
+            uint32_t generation = 0;
+            std::size_t num_lists[4] = {0, 0, 0, 0};
+            std::size_t num_child_args = 0;
+        };
+
+        struct FileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t expression_bytes;
+            uint32_t index_bytes;
+            uint64_t num_exprs;
+            uint64_t num_args;
+            uint64_t num_roots;
+            uint64_t num_strings;
+            uint64_t num_string_bytes;
+        };
+        using FileVersion = std::integral_constant<uint32_t, 1>;
+        // zeroes the padding of an expression of a PostOrderBlock before it is written
+        static void clear_padding(Expression& expr);
+
+        template<class T> static void write_items(std::ostream& os, const T* items, std::size_t count)
+        {
+            os.write(reinterpret_cast<const char*>(items), static_cast<std::streamsize>(count * sizeof(T)));
+        }
+        template<class T> static bool read_items(std::istream& is, T* items, std::size_t count)
+        {
+            is.read(reinterpret_cast<char*>(items), static_cast<std::streamsize>(count * sizeof(T)));
+            return static_cast<std::size_t>(is.gcount()) == count * sizeof(T);
+        }
+        // reads count items into column, which grows in steps so a truncated stream fails before
+        // the whole column is allocated
+        template<class Column> static bool read_column(std::istream& is, Column& column, uint64_t count)
+        {
+            column.clear();
+            for (std::size_t done = 0; done < count; )
+            {
+                auto step = static_cast<std::size_t>(std::min<uint64_t>(count - done, 1024*1024));
+                column.resize(done + step);
+                if (!read_items(is, column.data() + done, step)) return false;
+                done += step;
+            }
+            return true;
+        }
+
+        // creates the expressions of block in one contiguous range, string symbols are translated by symbol_map
+        template<class SymbolMap> Range fill_block(const PostOrderBlock& block, SymbolMap&& symbol_map);
+        // interns and marks the expressions filled from a block, the roots are referenced from outside
+        void created_block(const Range& expr_range, const uint32_t* roots, std::size_t num_roots);
+        // handle of the copy at a position of the block
+        static Index block_handle(uint32_t position, const Range& expr_range) { return (position != PostOrderBlock::NoPosition::value) ? expr_range[position] : Index(); }
+        template<uint32_t N> Index fill_arg_expr_list(Pool<ArgExpressionList<N>>& pool, Index list_idx, const uint32_t* positions, const Range& expr_range);
+
+        void erase_arg(uint32_t arg_type, Index arg_idx);
+
+        template<class T> static Expression inline_value_expression(uint32_t expr_type, T value)
+        {
+            // arg_idx may be narrower than the union, the bytes past the value are hashed and saved
+            Expression expr(expr_type, ArgTypes::WithValue<T>::value);
+            expr.value_uint64 = 0;
+            ExpressionValue<T>::get(expr) = value;
+            return expr;
+        }
+
+        static Expression string_expression(uint32_t expr_type, Symbol symbol)
+        {
+            Expression expr(expr_type, ArgTypes::WithValue<std::string>::value);
+            expr.value_uint64 = 0;
+            expr.value_symbol = symbol;
+            return expr;
+        }
+
+        template <class Iterator> Range create_with_values(uint32_t expr_type, Iterator first, Iterator last, std::true_type);
+        template <class Iterator> Range create_with_values(uint32_t expr_type, Iterator first, Iterator last, std::false_type);
+
+        enum class GcPhase { Idle, Mark, Sweep };
+
+        // every create ends here: interns the new expression and keeps it alive in a running collection
+        Index created(Index expr_idx);
+        void gc_mark(Index expr_idx);
+        bool gc_is_marked(Index expr_idx) const { return (expr_idx.index < m_gc_marked.size()) && m_gc_marked.test(expr_idx.index); }
+        void gc_cancel();
+        void gc_sweep_expr(Index expr_idx);
+
+        Index intern(Index expr_idx);
+        void unintern(Index expr_idx, const Expression& expr);
+        uint32_t& ref_count_slot(std::size_t index);
+        std::size_t hash_expression(const Expression& expr) const;
+        bool same_expression(const Expression& a, const Expression& b) const;
+        static bool has_inline_value(uint32_t arg_type);
+        static uint64_t inline_bits(const Expression& expr);
 
         Pool<Expression> m_expr_pool;
 
@@ -138,21 +492,39 @@ namespace v1 {
         Pool<ArgExpressionList<3>> m_arg_expr_list_3_pool;
         Pool<ArgExpressionList<4>> m_arg_expr_list_4_pool;
 
-        Pool<ArgValue<void*>> m_arg_value_voidptr_pool;
-        Pool<ArgValue<bool>> m_arg_value_bool_pool;
-        Pool<ArgValue<int8_t>> m_arg_value_int8_pool;
-        Pool<ArgValue<uint8_t>> m_arg_value_uint8_pool;
-        Pool<ArgValue<int16_t>> m_arg_value_int16_pool;
-        Pool<ArgValue<uint16_t>> m_arg_value_uint16_pool;
-        Pool<ArgValue<int32_t>> m_arg_value_int32_pool;
-        Pool<ArgValue<uint32_t>> m_arg_value_uint32_pool;
-        Pool<ArgValue<int64_t>> m_arg_value_int64_pool;
-        Pool<ArgValue<uint64_t>> m_arg_value_uint64_pool;
-        Pool<ArgValue<float>> m_arg_value_float_pool;
-        Pool<ArgValue<double>> m_arg_value_double_pool;
-        Pool<ArgValue<std::string>> m_arg_value_string_pool;
+        // arguments of WithArgList expressions, arg_idx.index is the offset of the first argument.
+        // erased lists stay in place until compact().
+        typename Policy::Storage::template container_type<Index> m_child_args;
+        std::size_t m_num_erased_child_args = 0;
+
+        Strings m_strings;
+
+        bool m_interning = false;
+        // interned expressions by hash_expression
+        std::unordered_multimap<std::size_t, Index, std::hash<std::size_t>, std::equal_to<std::size_t>, rebind_alloc_t<allocator_type, std::pair<const std::size_t, Index>>> m_interned;
+        // per expression slot, maintained while interning
+        typename Policy::Storage::template container_type<uint32_t> m_ref_counts;
+
+        GcPhase m_gc_phase = GcPhase::Idle;
+        // reached expressions by slot, slots created during the collection are marked too
+        typename Pool<Expression>::bitmap_type m_gc_marked;
+        // marked expressions whose arguments are not yet marked
+        typename Policy::Storage::template container_type<Index> m_gc_stack;
+        std::size_t m_gc_sweep_word = 0;
+        std::size_t m_gc_num_freed = 0;
+
+        // scratch of clone_subtree and load, kept for the next one
+        PostOrderBlock m_block;
     };
 
+    using Ast = Ast_<>;
+
+    // copies the subtree below root in src into dst, see Ast_::clone_subtree
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index clone_subtree(const Ast_<TPolicy>& src, typename Ast_<TPolicy>::Index root, Ast_<TPolicy>& dst)
+    {
+        return dst.clone_subtree(src, root);
+    }
 
 } // namespace v1
 } // namespace do_ast
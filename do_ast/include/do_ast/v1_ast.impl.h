@@ -1,18 +1,44 @@
 #pragma once
 
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
 #include <do_ast/v1_ast.h>
 
 namespace do_ast {
 namespace v1 {
 
-    template <class V>
-    void Ast::visit(V& visitor, ItemPoolIndex expr_idx)
+    template<class TPolicy>
+    Ast_<TPolicy>::Ast_(const allocator_type& alloc)
+    : m_expr_pool(alloc)
+    , m_arg_expr_list_1_pool(alloc)
+    , m_arg_expr_list_2_pool(alloc)
+    , m_arg_expr_list_3_pool(alloc)
+    , m_arg_expr_list_4_pool(alloc)
+    , m_child_args(alloc)
+    , m_strings(alloc)
+    , m_interned(alloc)
+    , m_ref_counts(alloc)
+    , m_gc_marked(alloc)
+    , m_gc_stack(alloc)
+    , m_block(alloc)
+    {}
+
+    template<class TPolicy>
+    template<class V>
+    void Ast_<TPolicy>::visit(V& visitor, Index expr_idx)
     {
         auto* expr = get(expr_idx);
         if (expr == nullptr)
         {
             visitor.nil(*this, expr_idx);
         }
+        else if (ArgTypes::is_arg_list(expr->arg_type))
+        {
+            visitor.with_arg_list(*this, expr_idx, expr->expr_type, args(*expr));
+        }
         else
         switch(expr->arg_type)
         {
@@ -52,72 +78,1153 @@ namespace v1 {
             }
             case ArgTypes::WithValue<void*>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_voidptr_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_voidptr); 
                 break;
             }
             case ArgTypes::WithValue<bool>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_bool_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_bool); 
                 break;
             }
             case ArgTypes::WithValue<int8_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_int8_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_int8); 
                 break;
             }
             case ArgTypes::WithValue<uint8_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_uint8_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_uint8); 
                 break;
             }
             case ArgTypes::WithValue<int16_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_int16_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_int16); 
                 break;
             }
             case ArgTypes::WithValue<uint16_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_uint16_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_uint16); 
                 break;
             }
             case ArgTypes::WithValue<int32_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_int32_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_int32); 
                 break;
             }
             case ArgTypes::WithValue<uint32_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_uint32_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_uint32); 
                 break;
             }
             case ArgTypes::WithValue<int64_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_int64_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_int64); 
                 break;
             }
             case ArgTypes::WithValue<uint64_t>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_uint64_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_uint64); 
                 break;
             }
             case ArgTypes::WithValue<float>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_float_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_float); 
                 break;
             }
             case ArgTypes::WithValue<double>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_double_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, expr->value_double); 
                 break;
             }
             case ArgTypes::WithValue<std::string>::value:
             {
-                visitor.with_value(*this, expr_idx, expr->expr_type, m_arg_value_string_pool.get(expr->arg_idx).value); 
+                visitor.with_value(*this, expr_idx, expr->expr_type, m_strings.get(expr->value_symbol)); 
+                break;
+            }
+        }
+    }
+
+    template<class TPolicy>
+    template<class R, class Leaf, class Node>
+    R Ast_<TPolicy>::fold(Index root, Leaf&& leaf, Node&& node, FoldContext<R>& ctx) const
+    {
+        using Frame = typename FoldContext<R>::Frame;
+        ctx.frames.clear();
+        ctx.results.clear();
+        const auto* root_expr = get(root);
+        if (!root_expr) return R();
+        auto root_args = args(*root_expr);
+        if (root_args.empty()) return leaf(root, *root_expr);
+        ctx.frames.push_back(Frame{root_args.begin(), root_args.end(), 0, root, root_expr});
+        while (true)
+        {
+            auto& frame = ctx.frames.back();
+            if (frame.next_arg != frame.last_arg)
+            {
+                auto arg_idx = *frame.next_arg++;
+                const auto* expr = get(arg_idx);
+                if (!expr)
+                {
+                    ctx.results.emplace_back();
+                    continue;
+                }
+                auto expr_args = args(*expr);
+                if (expr_args.empty())
+                {
+                    ctx.results.push_back(leaf(arg_idx, *expr));
+                    continue;
+                }
+                // invalidates frame
+                ctx.frames.push_back(Frame{expr_args.begin(), expr_args.end(), ctx.results.size(), arg_idx, expr});
+            }
+            else
+            {
+                const R* first = ctx.results.data() + frame.first_result;
+                R result = node(frame.expr_idx, *frame.expr, ArgRange_<R>{first, ctx.results.data() + ctx.results.size()});
+                ctx.results.erase(ctx.results.begin() + frame.first_result, ctx.results.end());
+                ctx.frames.pop_back();
+                if (ctx.frames.empty()) return result;
+                ctx.results.push_back(std::move(result));
+            }
+        }
+    }
+
+    template<class TPolicy>
+    template<class R, class Leaf, class Node>
+    R Ast_<TPolicy>::fold(Index root, Leaf&& leaf, Node&& node) const
+    {
+        FoldContext<R> ctx(m_expr_pool.get_allocator());
+        return fold<R>(root, leaf, node, ctx);
+    }
+
+    template<class TPolicy>
+    template<class T>
+    const T* Ast_<TPolicy>::value(Index expr_idx) const
+    {
+        const auto* expr = get(expr_idx);
+        return expr ? value<T>(*expr) : nullptr;
+    }
+
+    template<class TPolicy>
+    template<class T>
+    const T* Ast_<TPolicy>::value(const Expression& expr) const
+    {
+        static_assert(ExpressionValue<T>::value, "value<T> reads scalars, strings are read with string_value.");
+        if (expr.arg_type != ArgTypes::WithValue<T>::value) return nullptr;
+        return &ExpressionValue<T>::get(expr);
+    }
+
+    template<class TPolicy>
+    StringRef Ast_<TPolicy>::string_value(Index expr_idx) const
+    {
+        const auto* expr = get(expr_idx);
+        return expr ? string_value(*expr) : StringRef();
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Symbol Ast_<TPolicy>::symbol(Index expr_idx) const
+    {
+        const auto* expr = get(expr_idx);
+        return expr ? symbol(*expr) : Strings::NoSymbol::value;
+    }
+
+    template<class TPolicy>
+    template<class Iterator>
+    typename Ast_<TPolicy>::Range Ast_<TPolicy>::create_with_values(uint32_t expr_type, Iterator first, Iterator last)
+    {
+        using T = typename std::iterator_traits<Iterator>::value_type;
+        return create_with_values(expr_type, first, last, ExpressionValue<T>());
+    }
+
+    template<class TPolicy>
+    template<class Iterator>
+    typename Ast_<TPolicy>::Range Ast_<TPolicy>::create_with_values(uint32_t expr_type, Iterator first, Iterator last, std::true_type)
+    {
+        using T = typename std::iterator_traits<Iterator>::value_type;
+        auto expr_range = m_expr_pool.insert_n(static_cast<std::size_t>(std::distance(first, last)));
+        for (std::size_t k = 0; k < expr_range.size(); ++k, ++first)
+        {
+            m_expr_pool.get(expr_range[k]) = inline_value_expression<T>(expr_type, *first);
+            if (m_interning) ref_count_slot(expr_range[k].index) = 1;
+            if (m_gc_phase != GcPhase::Idle) gc_mark(expr_range[k]);
+        }
+        return expr_range;
+    }
+
+    template<class TPolicy>
+    template<class Iterator>
+    typename Ast_<TPolicy>::Range Ast_<TPolicy>::create_with_values(uint32_t expr_type, Iterator first, Iterator last, std::false_type)
+    {
+        // strings, each is interned into the string arena
+        using T = typename std::iterator_traits<Iterator>::value_type;
+        static_assert(std::is_convertible<T, StringRef>::value, "create_with_values takes inline value types (see ExpressionValue) or strings.");
+        auto expr_range = m_expr_pool.insert_n(static_cast<std::size_t>(std::distance(first, last)));
+        for (std::size_t k = 0; k < expr_range.size(); ++k, ++first)
+        {
+            m_expr_pool.get(expr_range[k]) = string_expression(expr_type, m_strings.intern(StringRef(*first)));
+            if (m_interning) ref_count_slot(expr_range[k].index) = 1;
+            if (m_gc_phase != GcPhase::Idle) gc_mark(expr_range[k]);
+        }
+        return expr_range;
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create(
+        uint32_t expr_type
+    )
+    {
+        return created(m_expr_pool.emplace(expr_type, ArgTypes::NoArgs::value, Index()));
+    }
+
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_args(
+        uint32_t expr_type, Index arg1
+    )
+    {
+        return created(m_expr_pool.emplace(expr_type, ArgTypes::WithArgs<1>::value, m_arg_expr_list_1_pool.insert({arg1})));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_args(
+        uint32_t expr_type, Index arg1, Index arg2
+    )
+    {
+        return created(m_expr_pool.emplace(expr_type, ArgTypes::WithArgs<2>::value, m_arg_expr_list_2_pool.insert({arg1, arg2})));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_args(
+        uint32_t expr_type, Index arg1, Index arg2, Index arg3
+    )
+    {
+        return created(m_expr_pool.emplace(expr_type, ArgTypes::WithArgs<3>::value, m_arg_expr_list_3_pool.insert({arg1, arg2, arg3})));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_args(
+        uint32_t expr_type, Index arg1, Index arg2, Index arg3, Index arg4
+    )
+    {
+        return created(m_expr_pool.emplace(expr_type, ArgTypes::WithArgs<4>::value, m_arg_expr_list_4_pool.insert({arg1, arg2, arg3, arg4})));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_args(
+        uint32_t expr_type, const Index* args, std::size_t num_args
+    )
+    {
+        assert(num_args <= ArgTypes::MaxArgListSize::value);
+        auto offset = m_child_args.size();
+        assert(offset <= ItemPoolIndexTraits<Index>::max_index());
+        m_child_args.insert(m_child_args.end(), args, args + num_args);
+        return created(m_expr_pool.emplace(expr_type, ArgTypes::WithArgList::value + static_cast<uint32_t>(num_args), Index{offset, 0}));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::ArgRange Ast_<TPolicy>::args(Index expr_idx) const
+    {
+        const auto* expr = get(expr_idx);
+        return expr ? args(*expr) : ArgRange();
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type
+    )
+    {
+        return created(m_expr_pool.emplace(expr_type, ArgTypes::WithValue<void>::value, Index()));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, void* value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, int8_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, bool value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, uint8_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, int16_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, uint16_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, int32_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, uint32_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, int64_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, uint64_t value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, float value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, double value
+    )
+    {
+        return created(m_expr_pool.insert(inline_value_expression(expr_type, value)));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_value(
+        uint32_t expr_type, StringRef value
+    )
+    {
+        return created(m_expr_pool.insert(string_expression(expr_type, m_strings.intern(value))));
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::create_with_symbol(
+        uint32_t expr_type, Symbol symbol
+    )
+    {
+        assert(symbol < m_strings.size());
+        return created(m_expr_pool.insert(string_expression(expr_type, symbol)));
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::erase_expr(Index expr_idx)
+    {
+        // when interning the arguments hold references handed over by the expression, its last reference
+        // gives them back, and an argument which loses its last one is erased as well
+        if (m_interning)
+        {
+            erase_expr_recursive(expr_idx);
+            return;
+        }
+        const auto* expr = get(expr_idx);
+        if (!expr) return;
+        erase_arg(expr->arg_type, expr->arg_idx);
+        m_expr_pool.erase(expr_idx);
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::erase_expr_recursive(Index expr_idx)
+    {
+        const auto* expr = get(expr_idx);
+        if (!expr) return;
+        if (m_interning)
+        {
+            // shared expressions stay until their last parent is erased
+            if (--m_ref_counts[expr_idx.index] > 0) return;
+            unintern(expr_idx, *expr);
+        }
+        if (ArgTypes::is_arg_list(expr->arg_type))
+        {
+            // the child arena does not move while erasing
+            for (auto item : args(expr_idx))
+            {
+                erase_expr_recursive(item);
+            }
+        }
+        else
+        switch(expr->arg_type)
+        {
+            case ArgTypes::WithArgs<1>::value: 
+            {
+                for (auto item : m_arg_expr_list_1_pool.get(expr->arg_idx))
+                {
+                    erase_expr_recursive(item);
+                }
+                break;
+            }
+            case ArgTypes::WithArgs<2>::value: 
+            {
+                for (auto item : m_arg_expr_list_2_pool.get(expr->arg_idx))
+                {
+                    erase_expr_recursive(item);
+                }
+                break;
+            }
+            case ArgTypes::WithArgs<3>::value: 
+            {
+                for (auto item : m_arg_expr_list_3_pool.get(expr->arg_idx))
+                {
+                    erase_expr_recursive(item);
+                }
+                break;
+            }
+            case ArgTypes::WithArgs<4>::value: 
+            {
+                for (auto item : m_arg_expr_list_4_pool.get(expr->arg_idx))
+                {
+                    erase_expr_recursive(item);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        erase_arg(expr->arg_type, expr->arg_idx);
+        m_expr_pool.erase(expr_idx);
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::erase_arg(uint32_t arg_type, Index arg_idx)
+    {
+        if (ArgTypes::is_arg_list(arg_type))
+        {
+            m_num_erased_child_args += ArgTypes::arg_list_size(arg_type);
+            return;
+        }
+        switch(arg_type)
+        {
+            case ArgTypes::NoArgs::value: 
+            {
+                break;
+            }
+            case ArgTypes::WithArgs<1>::value: 
+            {
+                m_arg_expr_list_1_pool.erase(arg_idx);
+                break;
+            }
+            case ArgTypes::WithArgs<2>::value: 
+            {
+                m_arg_expr_list_2_pool.erase(arg_idx);
+                break;
+            }
+            case ArgTypes::WithArgs<3>::value: 
+            {
+                m_arg_expr_list_3_pool.erase(arg_idx);
+                break;
+            }
+            case ArgTypes::WithArgs<4>::value: 
+            {
+                m_arg_expr_list_4_pool.erase(arg_idx);
+                break;
+            }
+            case ArgTypes::WithValue<void>::value:
+            {
+                // also scalar values and string symbols, they are stored inline
                 break;
             }
         }
     }
 
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Remap Ast_<TPolicy>::compact()
+    {
+        Remap arg_expr_list_1_remap = m_arg_expr_list_1_pool.compact();
+        Remap arg_expr_list_2_remap = m_arg_expr_list_2_pool.compact();
+        Remap arg_expr_list_3_remap = m_arg_expr_list_3_pool.compact();
+        Remap arg_expr_list_4_remap = m_arg_expr_list_4_pool.compact();
+
+        gc_cancel();
+        Remap expr_remap = m_expr_pool.compact();
+
+        // argument lists are copied densely in expression order
+        auto child_args = std::move(m_child_args);
+        m_child_args.clear();
+        m_child_args.reserve(child_args.size() - m_num_erased_child_args);
+        m_num_erased_child_args = 0;
+
+        for (std::size_t i = 0; i < m_expr_pool.size(); ++i)
+        {
+            auto& expr = m_expr_pool.get(m_expr_pool.index(i));
+            if (ArgTypes::is_arg_list(expr.arg_type))
+            {
+                auto first = child_args.begin() + expr.arg_idx.index;
+                expr.arg_idx = Index{m_child_args.size(), 0};
+                m_child_args.insert(m_child_args.end(), first, first + ArgTypes::arg_list_size(expr.arg_type));
+                continue;
+            }
+            switch(expr.arg_type)
+            {
+                case ArgTypes::WithArgs<1>::value:         expr.arg_idx = arg_expr_list_1_remap(expr.arg_idx); break;
+                case ArgTypes::WithArgs<2>::value:         expr.arg_idx = arg_expr_list_2_remap(expr.arg_idx); break;
+                case ArgTypes::WithArgs<3>::value:         expr.arg_idx = arg_expr_list_3_remap(expr.arg_idx); break;
+                case ArgTypes::WithArgs<4>::value:         expr.arg_idx = arg_expr_list_4_remap(expr.arg_idx); break;
+                default: break;
+            }
+        }
+
+        for (std::size_t i = 0; i < m_arg_expr_list_1_pool.size(); ++i) remap_handles(expr_remap, m_arg_expr_list_1_pool.get(m_arg_expr_list_1_pool.index(i)));
+        for (std::size_t i = 0; i < m_arg_expr_list_2_pool.size(); ++i) remap_handles(expr_remap, m_arg_expr_list_2_pool.get(m_arg_expr_list_2_pool.index(i)));
+        for (std::size_t i = 0; i < m_arg_expr_list_3_pool.size(); ++i) remap_handles(expr_remap, m_arg_expr_list_3_pool.get(m_arg_expr_list_3_pool.index(i)));
+        for (std::size_t i = 0; i < m_arg_expr_list_4_pool.size(); ++i) remap_handles(expr_remap, m_arg_expr_list_4_pool.get(m_arg_expr_list_4_pool.index(i)));
+        remap_handles(expr_remap, m_child_args);
+
+        if (m_interning)
+        {
+            // the handles changed, so did the hashes
+            auto ref_counts = std::move(m_ref_counts);
+            m_ref_counts.clear();
+            m_ref_counts.resize(m_expr_pool.size(), 0);
+            for (std::size_t src = 0; src < ref_counts.size() && src < expr_remap.new_index.size(); ++src)
+            {
+                const auto& dst = expr_remap.new_index[src];
+                if (dst.smc != 0) m_ref_counts[dst.index] = ref_counts[src];
+            }
+            m_interned.clear();
+            m_expr_pool.for_each_live([this](Index expr_idx, const Expression& expr) {
+                m_interned.emplace(hash_expression(expr), expr_idx);
+            });
+        }
+
+        return expr_remap;
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::clear()
+    {
+        gc_cancel();
+        m_expr_pool.clear();
+        m_arg_expr_list_1_pool.clear();
+        m_arg_expr_list_2_pool.clear();
+        m_arg_expr_list_3_pool.clear();
+        m_arg_expr_list_4_pool.clear();
+        m_child_args.clear();
+        m_num_erased_child_args = 0;
+        m_strings.clear();
+        m_interned.clear();
+        m_ref_counts.clear();
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::reset()
+    {
+        gc_cancel();
+        m_expr_pool.reset();
+        m_arg_expr_list_1_pool.reset();
+        m_arg_expr_list_2_pool.reset();
+        m_arg_expr_list_3_pool.reset();
+        m_arg_expr_list_4_pool.reset();
+        m_child_args.clear();
+        m_num_erased_child_args = 0;
+        m_strings.reset();
+        m_interned.clear();
+        m_ref_counts.clear();
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::set_interning(bool enabled)
+    {
+        m_interning = enabled;
+        m_interned.clear();
+        m_ref_counts.clear();
+        if (!enabled) return;
+        // existing expressions are interned as they are, equal ones stay separate
+        m_expr_pool.for_each_live([this](Index expr_idx, const Expression& expr) {
+            ref_count_slot(expr_idx.index) = 1;
+            m_interned.emplace(hash_expression(expr), expr_idx);
+        });
+    }
+
+    template<class TPolicy>
+    uint32_t Ast_<TPolicy>::ref_count(Index expr_idx) const
+    {
+        if (!get(expr_idx)) return 0;
+        return m_interning ? m_ref_counts[expr_idx.index] : 1;
+    }
+
+    template<class TPolicy>
+    Ast_<TPolicy>::PostOrderBlock::PostOrderBlock(const allocator_type& alloc)
+    : stack(alloc)
+    , exprs(alloc)
+    , args(alloc)
+    , results(alloc)
+    , remap(alloc)
+    , stamps(alloc)
+    {}
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::PostOrderBlock::clear()
+    {
+        // a new generation leaves the remap entries of earlier blocks behind without clearing them
+        if (++generation == 0)
+        {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            generation = 1;
+        }
+        stack.clear();
+        exprs.clear();
+        args.clear();
+        results.clear();
+        std::fill(num_lists, num_lists + 4, 0);
+        num_child_args = 0;
+    }
+
+    template<class TPolicy>
+    uint32_t Ast_<TPolicy>::PostOrderBlock::gather(const Ast_& src, Index root)
+    {
+        const auto* root_expr = src.get(root);
+        if (!root_expr) return NoPosition::value;
+        auto num_slots = src.m_expr_pool.occupancy().size();
+        if (remap.size() < num_slots)
+        {
+            remap.resize(num_slots, NoPosition::value);
+            stamps.resize(num_slots, 0);
+        }
+        if (stamps[root.index] == generation) return remap[root.index];
+
+        // post order without recursion, like fold. the positions of finished arguments wait on results
+        // until their parent finishes. remap entries stamped with this generation hold the position
+        // of the expressions in the block.
+        results.clear();
+        auto finish = [&](Index src_idx, const Expression& expr, std::size_t first_result)
+        {
+            Expression copy = expr;
+            if (first_result < results.size())
+            {
+                copy.arg_idx = Index{args.size(), 0};
+                args.insert(args.end(), results.begin() + first_result, results.end());
+                results.resize(first_result);
+            }
+            assert(exprs.size() < NoPosition::value);
+            auto position = static_cast<uint32_t>(exprs.size());
+            remap[src_idx.index] = position;
+            stamps[src_idx.index] = generation;
+            exprs.push_back(copy);
+            results.push_back(position);
+        };
+        stack.push_back(Frame{root, root_expr, src.args(*root_expr), 0});
+        while (!stack.empty())
+        {
+            auto& frame = stack.back();
+            if (frame.next_arg == frame.args.end())
+            {
+                finish(frame.expr_idx, *frame.expr, frame.first_result);
+                stack.pop_back();
+                continue;
+            }
+            auto arg = *frame.next_arg++;
+            const auto* expr = src.get(arg);
+            if (!expr)
+            {
+                results.push_back(NoPosition::value);
+                continue;
+            }
+            if (stamps[arg.index] == generation)
+            {
+                // shared, already in the block
+                results.push_back(remap[arg.index]);
+                continue;
+            }
+            auto args = src.args(*expr);
+            if (args.empty())
+            {
+                // leaves are finished right away, without a frame
+                finish(arg, *expr, results.size());
+                continue;
+            }
+            stack.push_back(Frame{arg, expr, args, results.size()});
+        }
+        return results.back();
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::PostOrderBlock::count_args()
+    {
+        std::fill(num_lists, num_lists + 4, 0);
+        num_child_args = 0;
+        for (const auto& expr : exprs)
+        {
+            if (ArgTypes::is_arg_list(expr.arg_type)) num_child_args += ArgTypes::arg_list_size(expr.arg_type);
+            else if ((expr.arg_type >= 1) && (expr.arg_type <= 4)) ++num_lists[expr.arg_type - 1];
+        }
+    }
+
+    template<class TPolicy>
+    template<class SymbolMap>
+    typename Ast_<TPolicy>::Range Ast_<TPolicy>::fill_block(const PostOrderBlock& block, SymbolMap&& symbol_map)
+    {
+        // every pool grows once, the expressions fill one block of slots in post order
+        auto expr_range = m_expr_pool.insert_n(block.exprs.size());
+        Range list_ranges[4] = {
+            m_arg_expr_list_1_pool.insert_n(block.num_lists[0]),
+            m_arg_expr_list_2_pool.insert_n(block.num_lists[1]),
+            m_arg_expr_list_3_pool.insert_n(block.num_lists[2]),
+            m_arg_expr_list_4_pool.insert_n(block.num_lists[3])
+        };
+        std::size_t next_list[4] = {0, 0, 0, 0};
+        m_child_args.reserve(m_child_args.size() + block.num_child_args);
+        for (std::size_t k = 0; k < block.exprs.size(); ++k)
+        {
+            Expression expr = block.exprs[k];
+            if (ArgTypes::is_arg_list(expr.arg_type))
+            {
+                std::size_t first = expr.arg_idx.index;
+                expr.arg_idx = Index{m_child_args.size(), 0};
+                for (std::size_t j = 0; j < ArgTypes::arg_list_size(expr.arg_type); ++j)
+                {
+                    m_child_args.push_back(block_handle(block.args[first + j], expr_range));
+                }
+            }
+            else
+            switch(expr.arg_type)
+            {
+                case ArgTypes::WithArgs<1>::value: expr.arg_idx = fill_arg_expr_list<1>(m_arg_expr_list_1_pool, list_ranges[0][next_list[0]++], block.args.data() + expr.arg_idx.index, expr_range); break;
+                case ArgTypes::WithArgs<2>::value: expr.arg_idx = fill_arg_expr_list<2>(m_arg_expr_list_2_pool, list_ranges[1][next_list[1]++], block.args.data() + expr.arg_idx.index, expr_range); break;
+                case ArgTypes::WithArgs<3>::value: expr.arg_idx = fill_arg_expr_list<3>(m_arg_expr_list_3_pool, list_ranges[2][next_list[2]++], block.args.data() + expr.arg_idx.index, expr_range); break;
+                case ArgTypes::WithArgs<4>::value: expr.arg_idx = fill_arg_expr_list<4>(m_arg_expr_list_4_pool, list_ranges[3][next_list[3]++], block.args.data() + expr.arg_idx.index, expr_range); break;
+                case ArgTypes::WithValue<std::string>::value: expr.value_symbol = symbol_map(expr.value_symbol); break;
+                default: break;
+            }
+            m_expr_pool.get(expr_range[k]) = expr;
+        }
+        return expr_range;
+    }
+
+    template<class TPolicy>
+    template<uint32_t N>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::fill_arg_expr_list(Pool<ArgExpressionList<N>>& pool, Index list_idx, const uint32_t* positions, const Range& expr_range)
+    {
+        auto& list = pool.get(list_idx);
+        for (std::size_t j = 0; j < N; ++j) list[j] = block_handle(positions[j], expr_range);
+        return list_idx;
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::created_block(const Range& expr_range, const uint32_t* roots, std::size_t num_roots)
+    {
+        if (m_interning)
+        {
+            // each expression is referenced by its parents within the block, the roots from outside
+            for (std::size_t k = 0; k < expr_range.size(); ++k) ref_count_slot(expr_range[k].index) = 0;
+            for (std::size_t k = 0; k < expr_range.size(); ++k)
+            {
+                for (auto arg : args(expr_range[k]))
+                {
+                    if (get(arg)) ++m_ref_counts[arg.index];
+                }
+            }
+            for (std::size_t k = 0; k < num_roots; ++k)
+            {
+                if (roots[k] != PostOrderBlock::NoPosition::value) ++m_ref_counts[expr_range[roots[k]].index];
+            }
+            for (std::size_t k = 0; k < expr_range.size(); ++k) m_interned.emplace(hash_expression(m_expr_pool.get(expr_range[k])), expr_range[k]);
+        }
+        if (m_gc_phase != GcPhase::Idle)
+        {
+            for (std::size_t k = 0; k < expr_range.size(); ++k) gc_mark(expr_range[k]);
+        }
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::clone_subtree(const Ast_& src, Index root)
+    {
+        // counting pass, then one copy pass over the block
+        m_block.clear();
+        auto position = m_block.gather(src, root);
+        if (position == PostOrderBlock::NoPosition::value) return Index();
+        m_block.count_args();
+        Range expr_range;
+        if (&src == this) expr_range = fill_block(m_block, [](Symbol symbol) { return symbol; });
+        else expr_range = fill_block(m_block, [&](Symbol symbol) { return m_strings.intern(src.m_strings.get(symbol)); });
+        created_block(expr_range, &position, 1);
+        return expr_range[position];
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::save(std::ostream& os, const Index* roots, std::size_t num_roots) const
+    {
+        static_assert(std::is_trivially_copyable<Expression>::value, "expressions are written as they are");
+        using NoPosition = typename PostOrderBlock::NoPosition;
+        auto alloc = m_expr_pool.get_allocator();
+        PostOrderBlock block(alloc);
+        block.clear();
+        typename Policy::Storage::template container_type<uint32_t> root_positions(alloc);
+        for (std::size_t k = 0; k < num_roots; ++k) root_positions.push_back(block.gather(*this, roots[k]));
+
+        // only the strings of the block are written, numbered in the order of their first expression
+        typename Policy::Storage::template container_type<uint32_t> string_ids(m_strings.size(), NoPosition::value, alloc);
+        typename Policy::Storage::template container_type<Symbol> string_symbols(alloc);
+        typename Policy::Storage::template container_type<uint32_t> string_sizes(alloc);
+        std::size_t num_string_bytes = 0;
+        for (auto& expr : block.exprs)
+        {
+            // the bytes of an expression which hold no field are zeroed, the same tree always gives the same file
+            clear_padding(expr);
+            if (expr.arg_type != ArgTypes::WithValue<std::string>::value) continue;
+            auto& id = string_ids[expr.value_symbol];
+            if (id == NoPosition::value)
+            {
+                auto str = m_strings.get(expr.value_symbol);
+                id = static_cast<uint32_t>(string_symbols.size());
+                string_symbols.push_back(expr.value_symbol);
+                string_sizes.push_back(static_cast<uint32_t>(str.size()));
+                num_string_bytes += str.size();
+            }
+            expr.value_symbol = id;
+        }
+
+        FileHeader header;
+        std::memset(static_cast<void*>(&header), 0, sizeof(header));
+        std::memcpy(header.magic, "DAST", 4);
+        header.version = FileVersion::value;
+        header.expression_bytes = sizeof(Expression);
+        header.index_bytes = sizeof(Index);
+        header.num_exprs = block.exprs.size();
+        header.num_args = block.args.size();
+        header.num_roots = root_positions.size();
+        header.num_strings = string_symbols.size();
+        header.num_string_bytes = num_string_bytes;
+        write_items(os, &header, 1);
+        write_items(os, block.exprs.data(), block.exprs.size());
+        write_items(os, block.args.data(), block.args.size());
+        write_items(os, root_positions.data(), root_positions.size());
+        write_items(os, string_sizes.data(), string_sizes.size());
+        for (auto symbol : string_symbols)
+        {
+            auto str = m_strings.get(symbol);
+            os.write(str.data(), static_cast<std::streamsize>(str.size()));
+        }
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::clear_padding(Expression& expr)
+    {
+        // rebuilt field by field on zeroed bytes. expressions with arguments hold the offset of their first
+        // argument in arg_idx, value expressions their 8 inline bytes.
+        Expression file_expr;
+        std::memset(static_cast<void*>(&file_expr), 0, sizeof(file_expr));
+        file_expr.expr_type = expr.expr_type;
+        file_expr.arg_type = expr.arg_type;
+        if (ArgTypes::is_arg_list(expr.arg_type) || ((expr.arg_type > ArgTypes::NoArgs::value) && (expr.arg_type <= 4)))
+        {
+            file_expr.arg_idx.index = expr.arg_idx.index;
+            file_expr.arg_idx.smc = expr.arg_idx.smc;
+        }
+        else if (expr.arg_type != ArgTypes::NoArgs::value)
+        {
+            std::memcpy(&file_expr.value_uint64, &expr.value_uint64, sizeof(uint64_t));
+        }
+        std::memcpy(static_cast<void*>(&expr), &file_expr, sizeof(Expression));
+    }
+
+    template<class TPolicy>
+    bool Ast_<TPolicy>::load(std::istream& is, std::vector<Index>& roots)
+    {
+        using NoPosition = typename PostOrderBlock::NoPosition;
+        FileHeader header;
+        if (!read_items(is, &header, 1)) return false;
+        if ((std::memcmp(header.magic, "DAST", 4) != 0) || (header.version != FileVersion::value)) return false;
+        if ((header.expression_bytes != sizeof(Expression)) || (header.index_bytes != sizeof(Index))) return false;
+        if ((header.num_exprs >= NoPosition::value) || (header.num_args >= NoPosition::value) || (header.num_strings >= NoPosition::value)) return false;
+
+        // the columns are read into the block as they are
+        auto alloc = m_expr_pool.get_allocator();
+        m_block.clear();
+        typename Policy::Storage::template container_type<uint32_t> root_positions(alloc);
+        typename Policy::Storage::template container_type<uint32_t> string_sizes(alloc);
+        typename Policy::Storage::template container_type<char> string_bytes(alloc);
+        if (!read_column(is, m_block.exprs, header.num_exprs)) return false;
+        if (!read_column(is, m_block.args, header.num_args)) return false;
+        if (!read_column(is, root_positions, header.num_roots)) return false;
+        if (!read_column(is, string_sizes, header.num_strings)) return false;
+        if (!read_column(is, string_bytes, header.num_string_bytes)) return false;
+
+        // nothing is created before the whole stream is checked: known arg types, strings in the string
+        // column, arguments before their parents
+        for (std::size_t k = 0; k < m_block.exprs.size(); ++k)
+        {
+            const auto& expr = m_block.exprs[k];
+            std::size_t num_args = 0;
+            if (ArgTypes::is_arg_list(expr.arg_type)) num_args = ArgTypes::arg_list_size(expr.arg_type);
+            else if (expr.arg_type <= 4) num_args = expr.arg_type;
+            else if ((expr.arg_type < ArgTypes::WithValue<void>::value) || (expr.arg_type > ArgTypes::WithValue<std::string>::value)) return false;
+            else if ((expr.arg_type == ArgTypes::WithValue<std::string>::value) && (expr.value_symbol >= header.num_strings)) return false;
+            if (num_args == 0) continue;
+            if (static_cast<std::size_t>(expr.arg_idx.index) + num_args > m_block.args.size()) return false;
+            for (std::size_t j = 0; j < num_args; ++j)
+            {
+                auto position = m_block.args[expr.arg_idx.index + j];
+                if ((position != NoPosition::value) && (position >= k)) return false;
+            }
+        }
+        for (auto position : root_positions)
+        {
+            if ((position != NoPosition::value) && (position >= header.num_exprs)) return false;
+        }
+        std::size_t num_string_bytes = 0;
+        for (auto size : string_sizes) num_string_bytes += size;
+        if (num_string_bytes != header.num_string_bytes) return false;
+
+        typename Policy::Storage::template container_type<Symbol> symbols(alloc);
+        const char* str = string_bytes.data();
+        for (auto size : string_sizes)
+        {
+            symbols.push_back(m_strings.intern(StringRef(str, size)));
+            str += size;
+        }
+        m_block.count_args();
+        auto expr_range = fill_block(m_block, [&](Symbol id) { return symbols[id]; });
+        created_block(expr_range, root_positions.data(), root_positions.size());
+        roots.clear();
+        for (auto position : root_positions) roots.push_back(block_handle(position, expr_range));
+        return true;
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::created(Index expr_idx)
+    {
+        expr_idx = intern(expr_idx);
+        if (m_gc_phase != GcPhase::Idle) gc_mark(expr_idx);
+        return expr_idx;
+    }
+
+    template<class TPolicy>
+    std::size_t Ast_<TPolicy>::collect(const Index* roots, std::size_t num_roots)
+    {
+        begin_collection(roots, num_roots);
+        collect_step(SIZE_MAX);
+        return m_gc_num_freed;
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::begin_collection(const Index* roots, std::size_t num_roots)
+    {
+        m_gc_phase = GcPhase::Mark;
+        m_gc_marked.assign(m_expr_pool.occupancy().size(), false);
+        m_gc_stack.clear();
+        m_gc_sweep_word = 0;
+        m_gc_num_freed = 0;
+        for (std::size_t k = 0; k < num_roots; ++k) gc_mark(roots[k]);
+    }
+
+    template<class TPolicy>
+    bool Ast_<TPolicy>::collect_step(std::size_t budget)
+    {
+        // marking keeps the pending expressions on an explicit stack, no recursion
+        while ((m_gc_phase == GcPhase::Mark) && (budget > 0))
+        {
+            if (m_gc_stack.empty())
+            {
+                m_gc_phase = GcPhase::Sweep;
+                break;
+            }
+            auto expr_idx = m_gc_stack.back();
+            m_gc_stack.pop_back();
+            --budget;
+            // erased since it was marked
+            const auto* expr = get(expr_idx);
+            if (!expr) continue;
+            for (auto arg : args(*expr)) gc_mark(arg);
+        }
+        // sweeping frees the occupied and unmarked slots, a whole word of 64 slots at a time
+        while ((m_gc_phase == GcPhase::Sweep) && (budget > 0))
+        {
+            const auto& occupancy = m_expr_pool.occupancy();
+            if (m_gc_sweep_word >= occupancy.num_words())
+            {
+                gc_cancel();
+                break;
+            }
+            auto w = m_gc_sweep_word++;
+            --budget;
+            auto marked = (w < m_gc_marked.num_words()) ? m_gc_marked.words()[w] : 0;
+            auto garbage = occupancy.words()[w] & ~marked;
+            while (garbage != 0)
+            {
+                gc_sweep_expr(m_expr_pool.index(w * OccupancyBitmap::WordBits::value + count_trailing_zeros(garbage)));
+                garbage &= garbage - 1;
+            }
+        }
+        return m_gc_phase == GcPhase::Idle;
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::gc_mark(Index expr_idx)
+    {
+        if (!get(expr_idx)) return;
+        if (expr_idx.index >= m_gc_marked.size()) m_gc_marked.resize(m_expr_pool.occupancy().size());
+        if (m_gc_marked.test(expr_idx.index)) return;
+        m_gc_marked.set(expr_idx.index);
+        // while sweeping the arguments of a live expression are marked already
+        if (m_gc_phase == GcPhase::Mark) m_gc_stack.push_back(expr_idx);
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::gc_cancel()
+    {
+        m_gc_phase = GcPhase::Idle;
+        m_gc_stack.clear();
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::gc_sweep_expr(Index expr_idx)
+    {
+        const auto& expr = m_expr_pool.get(expr_idx);
+        if (m_interning)
+        {
+            // references from garbage to live expressions are dropped, the garbage itself goes regardless of its count
+            for (auto arg : args(expr))
+            {
+                if (gc_is_marked(arg)) --m_ref_counts[arg.index];
+            }
+            unintern(expr_idx, expr);
+        }
+        erase_arg(expr.arg_type, expr.arg_idx);
+        m_expr_pool.erase(expr_idx);
+        ++m_gc_num_freed;
+    }
+
+    template<class TPolicy>
+    typename Ast_<TPolicy>::Index Ast_<TPolicy>::intern(Index expr_idx)
+    {
+        if (!m_interning) return expr_idx;
+        const auto& expr = m_expr_pool.get(expr_idx);
+        auto hash = hash_expression(expr);
+        auto candidates = m_interned.equal_range(hash);
+        for (auto it = candidates.first; it != candidates.second; ++it)
+        {
+            if (!same_expression(m_expr_pool.get(it->second), expr)) continue;
+            // an unmarked expression is garbage while sweeping, its arguments may be freed already
+            if ((m_gc_phase == GcPhase::Sweep) && !gc_is_marked(it->second)) continue;
+            // the existing expression already references the args, drop the references handed to the new one
+            for (auto arg : args(expr))
+            {
+                if (get(arg)) --m_ref_counts[arg.index];
+            }
+            erase_arg(expr.arg_type, expr.arg_idx);
+            m_expr_pool.erase(expr_idx);
+            ++m_ref_counts[it->second.index];
+            return it->second;
+        }
+        m_interned.emplace(hash, expr_idx);
+        ref_count_slot(expr_idx.index) = 1;
+        return expr_idx;
+    }
+
+    template<class TPolicy>
+    void Ast_<TPolicy>::unintern(Index expr_idx, const Expression& expr)
+    {
+        auto candidates = m_interned.equal_range(hash_expression(expr));
+        for (auto it = candidates.first; it != candidates.second; ++it)
+        {
+            if ((it->second.index == expr_idx.index) && (it->second.smc == expr_idx.smc))
+            {
+                m_interned.erase(it);
+                return;
+            }
+        }
+    }
+
+    template<class TPolicy>
+    uint32_t& Ast_<TPolicy>::ref_count_slot(std::size_t index)
+    {
+        if (index >= m_ref_counts.size()) m_ref_counts.resize(index + 1, 0);
+        return m_ref_counts[index];
+    }
+
+    template<class TPolicy>
+    std::size_t Ast_<TPolicy>::hash_expression(const Expression& expr) const
+    {
+        auto combine = [](std::size_t seed, std::size_t value) { return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2)); };
+        std::size_t hash = combine(expr.expr_type, expr.arg_type);
+        if (has_inline_value(expr.arg_type))
+        {
+            return combine(hash, std::hash<uint64_t>()(inline_bits(expr)));
+        }
+        for (auto arg : args(expr))
+        {
+            hash = combine(combine(hash, arg.index), arg.smc);
+        }
+        return hash;
+    }
+
+    template<class TPolicy>
+    bool Ast_<TPolicy>::same_expression(const Expression& a, const Expression& b) const
+    {
+        if ((a.expr_type != b.expr_type) || (a.arg_type != b.arg_type)) return false;
+        if (has_inline_value(a.arg_type))
+        {
+            return inline_bits(a) == inline_bits(b);
+        }
+        auto args_a = args(a);
+        auto args_b = args(b);
+        for (std::size_t k = 0; k < args_a.size(); ++k)
+        {
+            if ((args_a[k].index != args_b[k].index) || (args_a[k].smc != args_b[k].smc)) return false;
+        }
+        return true;
+    }
+
+    template<class TPolicy>
+    bool Ast_<TPolicy>::has_inline_value(uint32_t arg_type)
+    {
+        // strings are inline symbols, equal strings have equal symbols
+        return (arg_type > ArgTypes::WithValue<void>::value) && (arg_type <= ArgTypes::WithValue<std::string>::value);
+    }
+
+    template<class TPolicy>
+    uint64_t Ast_<TPolicy>::inline_bits(const Expression& expr)
+    {
+        // inline_value_expression zeroes the 8 bytes before it writes the value
+        uint64_t bits;
+        std::memcpy(&bits, &expr.value_uint64, sizeof(bits));
+        return bits;
+    }
+
+    // the default ast is instantiated once in v1_ast.cpp
+    extern template struct Ast_<ItemPoolPolicy<>>;
 
 } // namespace v1
 } // namespace do_ast
@@ -7,8 +7,12 @@
 namespace do_ast {
 namespace v1 {
 
-    struct TreePrinterVisitor
+    template<class TAst = Ast>
+    struct TreePrinterVisitor_
     {
+        using Index = typename TAst::Index;
+        using ArgRange = typename TAst::ArgRange;
+
         std::string indent = "    ";
         unsigned int current_indent = 0;
 
@@ -20,10 +24,10 @@ namespace v1 {
             }
         }
 
-        void print_expr_idx(ItemPoolIndex expr_idx)
+        void print_expr_idx(Index expr_idx)
         {
             std::cout << "idx[";
-            std::cout << std::setbase(16) << std::setfill('0') << std::setw(sizeof(ItemPoolIndex)/16) << expr_idx.index;
+            std::cout << std::setbase(16) << std::setfill('0') << std::setw(sizeof(Index)/16) << expr_idx.index;
             std::cout << ", ";
             print_value(expr_idx.smc);
             std::cout << "]";
@@ -82,12 +86,12 @@ namespace v1 {
         {
             std::cout << std::defaultfloat << std::setw(0) << value;
         }
-        void print_value(const std::string& value)
+        void print_value(StringRef value)
         {
             std::cout << "'" << value << "'";
         }
 
-        void nil(Ast& ast, ItemPoolIndex expr_idx) 
+        void nil(TAst& ast, Index expr_idx) 
         {
             print_indent();
             std::cout << "nil ";
@@ -95,7 +99,7 @@ namespace v1 {
             std::cout << "\n";
         }
 
-        void no_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type) 
+        void no_args(TAst& ast, Index expr_idx, uint32_t expr_type) 
         {
             print_indent();
             std::cout << "no_args ";
@@ -105,7 +109,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1) 
+        void with_args(TAst& ast, Index expr_idx, uint32_t expr_type, Index arg1) 
         {
             print_indent();
             std::cout << "with_args ";
@@ -119,7 +123,7 @@ namespace v1 {
 
         } 
 
-        void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2) 
+        void with_args(TAst& ast, Index expr_idx, uint32_t expr_type, Index arg1, Index arg2) 
         {
             print_indent();
             std::cout << "with_args ";
@@ -133,7 +137,7 @@ namespace v1 {
             --current_indent;
         } 
 
-        void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3) 
+        void with_args(TAst& ast, Index expr_idx, uint32_t expr_type, Index arg1, Index arg2, Index arg3) 
         {
             print_indent();
             std::cout << "with_args ";
@@ -148,7 +152,7 @@ namespace v1 {
             --current_indent;
         } 
 
-        void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3, ItemPoolIndex arg4) 
+        void with_args(TAst& ast, Index expr_idx, uint32_t expr_type, Index arg1, Index arg2, Index arg3, Index arg4) 
         {
             print_indent();
             std::cout << "with_args ";
@@ -164,7 +168,23 @@ namespace v1 {
             --current_indent;
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type) 
+        void with_arg_list(TAst& ast, Index expr_idx, uint32_t expr_type, ArgRange args) 
+        {
+            print_indent();
+            std::cout << "with_arg_list ";
+            print_expr_idx(expr_idx);
+            std::cout << " ";
+            print_expr_type(expr_type);
+            std::cout << "\n";
+            ++current_indent;
+            for (auto arg : args)
+            {
+                ast.visit(*this, arg);
+            }
+            --current_indent;
+        } 
+
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type) 
         {
             print_indent();
             std::cout << "with_value (void) ";
@@ -174,7 +194,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, void* value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, void* value) 
         {
             print_indent();
             std::cout << "with_value (void*) ";
@@ -186,7 +206,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, bool value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, bool value) 
         {
             print_indent();
             std::cout << "with_value (bool) ";
@@ -198,7 +218,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int8_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, int8_t value) 
         {
             print_indent();
             std::cout << "with_value (int8_t) ";
@@ -210,7 +230,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint8_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, uint8_t value) 
         {
             print_indent();
             std::cout << "with_value (uint8_t) ";
@@ -222,7 +242,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int16_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, int16_t value) 
         {
             print_indent();
             std::cout << "with_value (int16_t) ";
@@ -234,7 +254,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint16_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, uint16_t value) 
         {
             print_indent();
             std::cout << "with_value (uint16_t) ";
@@ -246,7 +266,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int32_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, int32_t value) 
         {
             print_indent();
             std::cout << "with_value (int32_t) ";
@@ -258,7 +278,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint32_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, uint32_t value) 
         {
             print_indent();
             std::cout << "with_value (uint32_t) ";
@@ -270,7 +290,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, int64_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, int64_t value) 
         {
             print_indent();
             std::cout << "with_value (int64_t) ";
@@ -282,7 +302,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint64_t value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, uint64_t value) 
         {
             print_indent();
             std::cout << "with_value (uint64_t) ";
@@ -294,7 +314,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, float value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, float value) 
         {
             print_indent();
             std::cout << "with_value (float) ";
@@ -306,7 +326,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, double value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, double value) 
         {
             print_indent();
             std::cout << "with_value (double) ";
@@ -318,7 +338,7 @@ namespace v1 {
             std::cout << "\n";
         } 
 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, const std::string& value) 
+        void with_value(TAst& ast, Index expr_idx, uint32_t expr_type, StringRef value) 
         {
             print_indent();
             std::cout << "with_value (string) ";
@@ -332,6 +352,8 @@ namespace v1 {
 
     };
 
+    using TreePrinterVisitor = TreePrinterVisitor_<>;
+
 } // namespace v1
 } // namespace do_ast
 
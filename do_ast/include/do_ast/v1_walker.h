@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <do_ast/v1_ast.h>
+
+namespace do_ast {
+namespace v1 {
+
+    enum class WalkAction
+    {
+        Continue,
+        SkipChildren, // returned by pre: the arguments are not walked, post is still called
+        Stop          // ends the walk
+    };
+
+    struct NoWalkCallback
+    {
+        template<class... Args> WalkAction operator()(Args&&...) const { return WalkAction::Continue; }
+    };
+
+    template<class TAst = Ast>
+    struct Walker_
+    {
+        // walks an ast without recursion, the pending expressions are kept on an explicit stack.
+        // the stack is kept between walks, a reused walker only allocates while the stack grows.
+        // the ast may not be modified during a walk.
+        using Ast = TAst;
+        using Index = typename Ast::Index;
+        using Expression = typename Ast::Expression;
+        using ArgRange = typename Ast::ArgRange;
+        using allocator_type = typename Ast::allocator_type;
+
+        Walker_() = default;
+        explicit Walker_(const allocator_type& alloc) : m_stack(alloc) {}
+
+        // callbacks return a WalkAction:
+        //   pre(expr_idx, expr, args)  before the arguments
+        //   in(expr_idx, expr, k)      between argument k-1 and argument k
+        //   post(expr_idx, expr, args) after the arguments
+        // handles without expression are skipped. returns Stop if a callback stopped the walk.
+        template<class Pre, class In, class Post>
+        WalkAction walk(const Ast& ast, Index root, Pre&& pre, In&& in, Post&& post);
+
+        template<class Pre>
+        WalkAction walk_pre_order(const Ast& ast, Index root, Pre&& pre)
+        {
+            return walk(ast, root, pre, NoWalkCallback(), NoWalkCallback());
+        }
+
+        template<class Post>
+        WalkAction walk_post_order(const Ast& ast, Index root, Post&& post)
+        {
+            return walk(ast, root, NoWalkCallback(), NoWalkCallback(), post);
+        }
+
+        // number of expressions on the stack, in pre and post the depth of the current expression
+        std::size_t depth() const { return m_stack.size(); }
+
+        void shrink_to_fit() { m_stack.shrink_to_fit(); }
+
+    protected:
+        struct Frame
+        {
+            Index expr_idx;
+            const Expression* expr;
+            ArgRange args;
+            std::size_t next_arg;
+        };
+
+        template<class Pre, class Post>
+        WalkAction enter(const Ast& ast, Index expr_idx, Pre& pre, Post& post);
+
+        typename Ast::Policy::Storage::template container_type<Frame> m_stack;
+    };
+
+    using Walker = Walker_<>;
+
+} // namespace v1
+} // namespace do_ast
+
+#include <do_ast/v1_walker.impl.h>
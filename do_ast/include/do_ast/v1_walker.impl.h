@@ -0,0 +1,53 @@
+#pragma once
+
+#include <do_ast/v1_walker.h>
+
+namespace do_ast {
+namespace v1 {
+
+    template<class TAst>
+    template<class Pre, class In, class Post>
+    WalkAction Walker_<TAst>::walk(const Ast& ast, Index root, Pre&& pre, In&& in, Post&& post)
+    {
+        m_stack.clear();
+        if (enter(ast, root, pre, post) == WalkAction::Stop) return WalkAction::Stop;
+        while (!m_stack.empty())
+        {
+            auto& frame = m_stack.back();
+            if (frame.next_arg < frame.args.size())
+            {
+                auto k = frame.next_arg++;
+                if ((k > 0) && (in(frame.expr_idx, *frame.expr, k) == WalkAction::Stop)) return WalkAction::Stop;
+                // enter may reallocate the stack, frame is not used afterwards
+                if (enter(ast, frame.args[k], pre, post) == WalkAction::Stop) return WalkAction::Stop;
+            }
+            else
+            {
+                Frame done = frame;
+                m_stack.pop_back();
+                if (post(done.expr_idx, *done.expr, done.args) == WalkAction::Stop) return WalkAction::Stop;
+            }
+        }
+        return WalkAction::Continue;
+    }
+
+    template<class TAst>
+    template<class Pre, class Post>
+    WalkAction Walker_<TAst>::enter(const Ast& ast, Index expr_idx, Pre& pre, Post& post)
+    {
+        const auto* expr = ast.get(expr_idx);
+        if (!expr) return WalkAction::Continue;
+        auto args = ast.args(*expr);
+        auto action = pre(expr_idx, *expr, args);
+        if (action == WalkAction::Stop) return WalkAction::Stop;
+        if (args.empty() || (action == WalkAction::SkipChildren))
+        {
+            // nothing to walk below, the expression does not need a frame
+            return (post(expr_idx, *expr, args) == WalkAction::Stop) ? WalkAction::Stop : WalkAction::Continue;
+        }
+        m_stack.push_back(Frame{expr_idx, expr, args, 0});
+        return WalkAction::Continue;
+    }
+
+} // namespace v1
+} // namespace do_ast
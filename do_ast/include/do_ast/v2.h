@@ -1,11 +1,18 @@
 #pragma once
 
 #include <string>
+#include <algorithm>
+#include <functional>
 #include <array>
 #include <cstdint>
+#include <cassert>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <do_ast/v2_value_union.h>
+#include <do_ast/v2_traversal.h>
+#include <do_ast/v2_schedule.h>
 #include <do_ast/item_pool_tuple.h>
 
 namespace do_ast {
@@ -45,6 +52,16 @@ namespace v2 {
             set_<0>(args...);
         }
 
+        // rewrites the argument handles, e.g. with the ItemPoolRemap returned by compact()
+        template<class Remap>
+        void remap(const Remap& remap)
+        {
+            for (uint32_t k = 0; k < num_args; ++k)
+            {
+                args[k] = remap(args[k]);
+            }
+        }
+
     protected:
         template<uint32_t Idx=0, class Arg, std::enable_if_t<(Idx < TCount), bool> = true>
         void set_(Arg arg)
@@ -61,43 +78,238 @@ namespace v2 {
     };
 
 
-    template<class TTypeClass = uint32_t, class TRelations = Relations_<ItemPoolIndex, 4>, class TValue = ValueUnion<sizeof(double)>>
+    template<class TIndex, class TNumArgs = uint32_t>
+    struct RelationsView_
+    {
+        // arguments of an expression read from a child arena, with the members of Relations_
+        using Index = TIndex;
+
+        const Index* args = nullptr;
+        TNumArgs num_args = 0;
+    };
+
+    template<class TIndex>
+    struct ArenaRelations_
+    {
+        // relations column entry of Expressions which keeps the arguments in a child arena shared by all
+        // expressions. a leaf takes the 8 bytes of the entry and nothing in the arena, the number of
+        // arguments is not limited. traversals hand a RelationsView_ to the callbacks.
+        using Index = TIndex;
+
+        uint32_t first = 0;
+        uint32_t num_args = 0;
+    };
+
+    template<class TRelations>
+    struct RelationsTraits
+    {
+        // the relations column holds the arguments, callbacks read the entry in place
+        using IsArena = std::false_type;
+        using View = TRelations;
+    };
+
+    template<class TIndex>
+    struct RelationsTraits<ArenaRelations_<TIndex>>
+    {
+        using IsArena = std::true_type;
+        using View = RelationsView_<TIndex>;
+    };
+
+    template<class TRelations, class TIndex>
+    struct RelationsReader_
+    {
+        // reads the relations of an expression slot: the column entry itself, or a view into the child arena.
+        //   const auto& rel = relations[idx]; rel.args[k]; rel.num_args;
+        using IsArena = typename RelationsTraits<TRelations>::IsArena;
+        using View = typename RelationsTraits<TRelations>::View;
+
+        const TRelations* column = nullptr;
+        const TIndex* arena = nullptr;
+
+        decltype(auto) operator[](std::size_t idx) const { return get(idx, IsArena()); }
+
+    protected:
+        const View& get(std::size_t idx, std::false_type) const { return column[idx]; }
+        View get(std::size_t idx, std::true_type) const
+        {
+            const auto& entry = column[idx];
+            return View{arena + entry.first, entry.num_args};
+        }
+    };
+
+    template<class TExpression, class TAllocator = std::allocator<char>>
+    struct TraversalContext_
+    {
+        // scratch stack of the traversals of Expressions, owned by the caller and reused between traversals
+        // so only the first traversals allocate. the traversals keep no other state: threads that each
+        // pass their own context may traverse one pool at the same time while nobody modifies it.
+        using Expression = TExpression;
+        using allocator_type = TAllocator;
+        template<class U> using vector_type = std::vector<U, rebind_alloc_t<TAllocator, U>>;
+
+        struct Frame
+        {
+            Expression expr;
+            int depth = 0;
+            int step = 0;
+            int processed_args = 0;
+            int num_args = 0;
+
+            Frame() = default;
+            Frame(Expression expr, int depth) : expr(expr), depth(depth) {}
+        };
+
+        TraversalContext_() = default;
+        explicit TraversalContext_(const allocator_type& alloc) : stack(alloc) {}
+
+        vector_type<Frame> stack;
+    };
+
+    template<
+        class TTypeClass = uint32_t, 
+        class TRelations = Relations_<ItemPoolIndex, 4>, 
+        class TValue = ValueUnion<sizeof(double)>, 
+        class TPolicy = ItemPoolPolicy<VectorStorage, typename TRelations::Index>
+    >
     struct Expressions
     {
         using TypeClass = TTypeClass;
         using Relations = TRelations;
-        using Value = TValue;
+        using Value = column_value_t<TValue>; // TValue may be Lazy<Value>, see lazy_column.h
+        using Policy = TPolicy;
 
         static_assert(std::is_copy_assignable<TypeClass>::value, "std::is_copy_assignable<TypeClass>");
         static_assert(std::is_copy_assignable<Value>::value, "std::is_copy_assignable<Value>");
         static_assert(std::is_copy_assignable<Relations>::value, "std::is_copy_assignable<Relations>");
-        static_assert((sizeof(Relations) % 16 == 0),"sizeof(Relations) % 16 == 0");
+        static_assert((sizeof(Relations) % 16 == 0) || RelationsTraits<Relations>::IsArena::value,"sizeof(Relations) % 16 == 0");
+        static_assert(std::is_same<typename Relations::Index, typename Policy::Index>::value, "Relations and pool must use the same handle type.");
         // static_assert(sizeof(Value) % 16 == 0, "sizeof(Value) % 16 == 0");
         //ItemPoolTuple<TypeClass, Value> pool;
-        ItemPoolTuple<TypeClass, Relations, Value> pool;
-
-        using Expression = ItemPoolIndex;
-
+        ItemPoolTuple_<Policy, TypeClass, Relations, TValue> pool;
+
+        using Expression = typename Policy::Index;
+        using Remap = ItemPoolRemap_<Expression>;
+        using allocator_type = typename Policy::Storage::allocator_type;
+        template<class T> using container_type = typename Policy::Storage::template container_type<T>;
+        using TraversalContext = TraversalContext_<Expression, allocator_type>;
+        // what the traversals hand to the callbacks as relations, Relations or a view into the child arena
+        using RelationsView = typename RelationsTraits<Relations>::View;
+        using RelationsReader = RelationsReader_<Relations, Expression>;
+        using Schedule = Schedule_<Expression, allocator_type>;
+
+        Expressions() = default;
+        // the pool allocates from alloc
+        explicit Expressions(const allocator_type& alloc)
+        : pool(alloc)
+        , m_child_arena(alloc)
+        , m_schedules(alloc)
+        , m_schedule_marks(alloc)
+        , m_schedule_ctx(alloc)
+        {}
+
+        // a new expression is below no existing expression, insert does not count as modification.
+        // a slot freed by erase is only reused after erase counted one.
         Expression insert(TypeClass type, Relations rel=Relations(), Value val = Value::Void()) 
         { 
-            return pool.insert(type, rel, val); 
+            return pool.insert(type, rel, std::move(val)); 
         }
 
-        template<class Callback>
-        void traverse_pre_order(Expression expr, Callback cb)
+        // inserts an expression with the arguments args[0..num_args), for Relations_ and ArenaRelations_ alike
+        Expression insert_with_args(TypeClass type, const Expression* args, std::size_t num_args, Value val = Value::Void())
+        {
+            return pool.insert(type, make_relations(args, num_args, IsArena()), std::move(val));
+        }
+
+        void erase(Expression expr)
+        {
+            pool.erase(expr);
+            touch();
+        }
+
+        void set_relations(Expression expr, const Relations& rel)
+        {
+            pool.template get<1>(expr) = rel;
+            touch();
+        }
+
+        // replaces the arguments of expr. with a child arena the old arguments stay in it until compact.
+        void set_args(Expression expr, const Expression* args, std::size_t num_args)
+        {
+            set_relations(expr, make_relations(args, num_args, IsArena()));
+        }
+
+        // reads the relations of expression slots, see RelationsReader_
+        RelationsReader relations() const { return RelationsReader{pool.template slots<1>().data(), m_child_arena.data()}; }
+        // arguments of all expressions with ArenaRelations_, empty otherwise
+        const container_type<Expression>& child_arena() const { return m_child_arena; }
+
+        // O(1) removal of all expressions, keeps the capacity for the next build.
+        // outstanding expression handles become invalid.
+        void reset()
         {
-            const auto* types     = pool.slots<0>().data();
-            const auto* relations = pool.slots<1>().data();
-            const auto* values    = pool.slots<2>().data();
+            pool.reset();
+            m_child_arena.clear();
+            touch();
+        }
+
+        // moves live expressions to the front of the pool and rewrites all relations.
+        // the returned remap translates expression handles held outside of the pool.
+        Remap compact()
+        {
+            touch();
+            auto remap = pool.compact();
+            compact_relations(remap, IsArena());
+            return remap;
+        }
+
+        // counts the modifications of the pool structure: erase, set_relations, reset and compact.
+        // values are read when a schedule is evaluated, writing them is no modification.
+        uint64_t modification_count() const { return m_modification_count; }
+        // call after writing relations or erasing through pool directly
+        void touch() { ++m_modification_count; }
 
-            struct StackItem
+        // evaluation order of the expressions below root, see v2_schedule.h.
+        // built on the first call and rebuilt only when the pool was modified since, the reference stays
+        // valid until the next call of schedule or clear_schedules. roots are cached by slot.
+        const Schedule& schedule(Expression root)
+        {
+            auto* schedule = find_schedule(root);
+            if ((schedule->modification != m_modification_count) || (schedule->num_builds == 0) || (schedule->root.smc != root.smc))
             {
-                Expression expr;
-                int depth;
-            };
+                build_schedule(root, *schedule);
+            }
+            return *schedule;
+        }
+
+        // frees all cached schedules
+        void clear_schedules()
+        {
+            m_schedules.clear();
+            m_schedule_marks.clear();
+        }
+
+        template<class TOrder> using Traversal = Traversal_<Expressions, TOrder>;
+
+        // lazy traversals, see v2_traversal.h. the consumer may skip subtrees or stop early.
+        Traversal<PreOrder> pre_order(Expression root, TraversalContext& ctx) const { return Traversal<PreOrder>(*this, root, ctx); }
+        Traversal<PostOrder> post_order(Expression root, TraversalContext& ctx) const { return Traversal<PostOrder>(*this, root, ctx); }
+        template<class TEvents = AllInOrderEvents>
+        Traversal<InOrder<TEvents>> in_order(Expression root, TraversalContext& ctx) const { return Traversal<InOrder<TEvents>>(*this, root, ctx); }
+
+        // the traversals only read the pool, their stack lives in ctx.
+        // pass the same ctx to later traversals so they do not allocate, callbacks may not traverse with ctx.
+        // the overloads without ctx allocate a context per call.
 
-            std::vector<StackItem> stack;
-            stack.push_back({expr,0});
+        template<class Callback>
+        void traverse_pre_order(Expression expr, Callback cb, TraversalContext& ctx) const
+        {
+            const auto* types     = pool.template slots<0>().data();
+            auto relations = this->relations();
+            const auto& values    = pool.template slots<2>(); // by reference, a Lazy value column is not materialized
+
+            auto& stack = ctx.stack;
+            stack.clear();
+            stack.emplace_back(expr, 0);
             while (!stack.empty())
             {
                 auto item = stack.back();
@@ -111,7 +323,7 @@ namespace v2 {
                     auto arg = rel.args[rel.num_args-1-k];
                     if (pool.contains(arg))
                     {
-                        stack.push_back({arg, item.depth+1});
+                        stack.emplace_back(arg, item.depth+1);
                     }
                 }
             }
@@ -119,29 +331,22 @@ namespace v2 {
         }
 
         template<class Callback>
-        void traverse_post_order(Expression expr, Callback cb)
+        void traverse_pre_order(Expression expr, Callback cb) const
         {
-            const auto* types     = pool.slots<0>().data();
-            const auto* relations = pool.slots<1>().data();
-            const auto* values    = pool.slots<2>().data();
+            TraversalContext ctx(pool.get_allocator());
+            traverse_pre_order(expr, cb, ctx);
+        }
 
-            struct StackItem
-            {
-                Expression expr;
-                int depth;
-                bool done = false;
-                uint64_t _padding;
-
-                StackItem() = default;
-                StackItem(Expression expr, int depth) 
-                : expr(expr), depth(depth) {}
-            };
-            // std::cout << "sizeof(StackItem) " << sizeof(StackItem) << "\n";
-
-            static std::vector<StackItem> stack;
+        template<class Callback>
+        void traverse_post_order(Expression expr, Callback cb, TraversalContext& ctx) const
+        {
+            const auto* types     = pool.template slots<0>().data();
+            auto relations = this->relations();
+            const auto& values    = pool.template slots<2>();
+
+            auto& stack = ctx.stack;
             stack.clear();
-            stack.reserve(1024);
-            stack.push_back({expr,0});
+            stack.emplace_back(expr, 0);
             while (!stack.empty())
             {
                 auto idx_item = stack.size()-1;
@@ -150,7 +355,8 @@ namespace v2 {
                 auto idx = item.expr.index;
                 const auto& rel = relations[item.expr.index];
 
-                if (item.done || (rel.num_args == 0))
+                // step 1: the arguments are done
+                if (item.step || (rel.num_args == 0))
                 {
                     cb(item.depth, item.expr, types[idx], rel, values[idx]);
                     stack.pop_back();
@@ -163,52 +369,47 @@ namespace v2 {
                         auto arg = rel.args[rel.num_args-1-k];
                         if (pool.contains(arg))
                         {
-                            // stack.push_back({arg, new_depth});
                             stack.emplace_back(arg, new_depth);
                         }
                     }
                     // auto&item is invalidated after stack.push_back
-                    stack[idx_item].done = true;
+                    stack[idx_item].step = 1;
                 }
             }
         }
 
+        template<class Callback>
+        void traverse_post_order(Expression expr, Callback cb) const
+        {
+            TraversalContext ctx(pool.get_allocator());
+            traverse_post_order(expr, cb, ctx);
+        }
+
         template<class CallbackPre, class CallbackIn, class CallbackPost>
         void traverse_in_order(
             Expression expr, 
             CallbackPre cbPreOrder, 
             CallbackIn cbInOrder, 
             CallbackPost cbPostOrder,
+            TraversalContext& ctx,
             bool enable_pre_order = true,
             bool enable_in_order = true,
             bool enable_post_order = true
-        )
+        ) const
         {
-            const auto* types     = pool.slots<0>().data();
-            const auto* relations = pool.slots<1>().data();
-            const auto* values    = pool.slots<2>().data();
+            const auto* types     = pool.template slots<0>().data();
+            auto relations = this->relations();
+            const auto& values    = pool.template slots<2>();
 
             decltype(types) null_types = nullptr;
-            decltype(relations) null_relations = nullptr;
-            decltype(values) null_values = nullptr;
+            const RelationsView* null_relations = nullptr;
+            const Value* null_values = nullptr;
 
-            struct StackFrame
-            {
-                Expression expr;
-                int depth = 0;
-                int step = 0;
-                
-
-                // bool started = false;
-                int processed_args = 0;
-                int num_args = 0;
-            };
-
-            std::vector<StackFrame> stack;
-            stack.push_back({expr,0});
+            auto& stack = ctx.stack;
+            stack.clear();
+            stack.emplace_back(expr, 0);
             while (!stack.empty())
             {
-                auto idx_item = stack.size()-1;
                 auto& item = stack.back();
                 
                 if (!pool.contains(item.expr))
@@ -243,7 +444,7 @@ namespace v2 {
                     item.num_args = rel.num_args;
 
                     auto arg = rel.args[0];
-                    stack.push_back({arg, new_depth});
+                    stack.emplace_back(arg, new_depth);
                     continue;
                 }
                 if (item.step == 1)
@@ -261,13 +462,152 @@ namespace v2 {
 
                     auto arg = rel.args[item.processed_args];
                     ++item.processed_args;
-                    stack.push_back({arg, new_depth});
+                    stack.emplace_back(arg, new_depth);
                     continue;
                 }
             }
 
         }
 
+        template<class CallbackPre, class CallbackIn, class CallbackPost>
+        void traverse_in_order(
+            Expression expr, 
+            CallbackPre cbPreOrder, 
+            CallbackIn cbInOrder, 
+            CallbackPost cbPostOrder,
+            bool enable_pre_order = true,
+            bool enable_in_order = true,
+            bool enable_post_order = true
+        ) const
+        {
+            TraversalContext ctx(pool.get_allocator());
+            traverse_in_order(expr, cbPreOrder, cbInOrder, cbPostOrder, ctx, enable_pre_order, enable_in_order, enable_post_order);
+        }
+
+    protected:
+        using IsArena = typename RelationsTraits<Relations>::IsArena;
+
+        Relations make_relations(const Expression* args, std::size_t num_args, std::false_type) const
+        {
+            assert(num_args <= Relations::Count::value);
+            Relations rel;
+            for (std::size_t k = 0; k < num_args; ++k) rel.args[k] = args[k];
+            rel.num_args = static_cast<decltype(rel.num_args)>(num_args);
+            return rel;
+        }
+
+        Relations make_relations(const Expression* args, std::size_t num_args, std::true_type)
+        {
+            assert(m_child_arena.size() + num_args < UINT32_MAX);
+            // args may point into the arena itself, e.g. a RelationsView passed to set_args
+            auto first = m_child_arena.size();
+            const auto* begin = m_child_arena.data();
+            bool inside = std::greater_equal<const Expression*>()(args, begin) && std::less<const Expression*>()(args, begin + first);
+            auto offset = inside ? (args - begin) : 0;
+            m_child_arena.resize(first + num_args);
+            const auto* src = inside ? (m_child_arena.data() + offset) : args;
+            std::copy(src, src + num_args, m_child_arena.begin() + first);
+            Relations rel;
+            rel.first = static_cast<uint32_t>(first);
+            rel.num_args = static_cast<uint32_t>(num_args);
+            return rel;
+        }
+
+        void compact_relations(const Remap& remap, std::false_type)
+        {
+            auto* relations = pool.template slots<1>().data();
+            for (std::size_t i = 0; i < pool.size(); ++i)
+            {
+                relations[i].remap(remap);
+            }
+        }
+
+        void compact_relations(const Remap& remap, std::true_type)
+        {
+            // the arguments of the live expressions are copied in slot order, which drops those of erased
+            // expressions and those replaced by set_args
+            auto* relations = pool.template slots<1>().data();
+            std::size_t num_args = 0;
+            for (std::size_t i = 0; i < pool.size(); ++i) num_args += relations[i].num_args;
+            container_type<Expression> arena(m_child_arena.get_allocator());
+            arena.reserve(num_args);
+            for (std::size_t i = 0; i < pool.size(); ++i)
+            {
+                auto& rel = relations[i];
+                auto first = static_cast<uint32_t>(arena.size());
+                for (uint32_t k = 0; k < rel.num_args; ++k) arena.push_back(remap(m_child_arena[rel.first + k]));
+                rel.first = first;
+            }
+            m_child_arena.swap(arena);
+        }
+
+        Schedule* find_schedule(Expression root)
+        {
+            for (auto& schedule : m_schedules)
+            {
+                if (schedule.root.index == root.index) return &schedule;
+            }
+            m_schedules.emplace_back(pool.get_allocator());
+            m_schedules.back().root = root;
+            return &m_schedules.back();
+        }
+
+        void build_schedule(Expression root, Schedule& schedule)
+        {
+            // post order walk which emits an expression when its arguments are done.
+            // a mark stamped with the build number skips the second visit of a shared expression, it is set
+            // when the expression is emitted so a parent always comes after the shared argument.
+            auto relations = this->relations();
+            schedule.clear();
+            schedule.root = root;
+            schedule.modification = m_modification_count;
+            ++schedule.num_builds;
+            auto num_slots = pool.template slots<1>().size();
+            if (m_schedule_marks.size() < num_slots) m_schedule_marks.resize(num_slots, 0);
+            auto mark = ++m_schedule_mark;
+            auto& stack = m_schedule_ctx.stack;
+            stack.clear();
+            if (pool.contains(root)) stack.emplace_back(root, 0);
+            while (!stack.empty())
+            {
+                auto idx_item = stack.size()-1;
+                auto idx = stack.back().expr.index;
+                const auto& rel = relations[idx];
+                if (stack.back().step == 0)
+                {
+                    if (m_schedule_marks[idx] == mark)
+                    {
+                        stack.pop_back();
+                        continue;
+                    }
+                    for (uint32_t k = 0; k < rel.num_args; ++k)
+                    {
+                        auto arg = rel.args[rel.num_args-1-k];
+                        if (pool.contains(arg) && (m_schedule_marks[arg.index] != mark)) stack.emplace_back(arg, 0);
+                    }
+                    stack[idx_item].step = 1;
+                    continue;
+                }
+                stack.pop_back();
+                m_schedule_marks[idx] = mark;
+                auto first_arg = static_cast<uint32_t>(schedule.args.size());
+                for (uint32_t k = 0; k < rel.num_args; ++k)
+                {
+                    if (pool.contains(rel.args[k])) schedule.args.push_back(static_cast<uint32_t>(rel.args[k].index));
+                }
+                auto num_args = static_cast<uint32_t>(schedule.args.size()) - first_arg;
+                if (num_args == 0) schedule.leaves.push_back(static_cast<uint32_t>(idx));
+                else schedule.steps.push_back({static_cast<uint32_t>(idx), first_arg, num_args});
+            }
+        }
+
+        container_type<Expression> m_child_arena;
+        uint64_t m_modification_count = 0;
+        // cached schedules, one per root slot
+        container_type<Schedule> m_schedules;
+        container_type<uint64_t> m_schedule_marks;
+        uint64_t m_schedule_mark = 0;
+        TraversalContext m_schedule_ctx;
     };
 
 } // namespace v2
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <do_ast/arena_allocator.h>
+
+namespace do_ast {
+namespace v2 {
+
+    template<class TExpression, class TAllocator = std::allocator<char>>
+    struct Schedule_
+    {
+        // linear evaluation order of the expressions below a root, as pool slots.
+        // every expression appears once, also when several parents share it. the leaves come first,
+        // then the expressions with arguments in post order, so each step comes after all its arguments:
+        //   for (const auto& step : schedule.steps) { values[step.slot] = f(values[schedule.args[step.first_arg + k]]...); }
+        // args of a step only hold the arguments which are in the pool.
+        // built and cached by Expressions::schedule(root), valid until the next modification of the pool.
+        using Expression = TExpression;
+        using allocator_type = TAllocator;
+        template<class U> using vector_type = std::vector<U, rebind_alloc_t<TAllocator, U>>;
+
+        struct Step
+        {
+            uint32_t slot;
+            uint32_t first_arg;
+            uint32_t num_args;
+        };
+
+        Schedule_() = default;
+        explicit Schedule_(const allocator_type& alloc)
+        : leaves(alloc)
+        , steps(alloc)
+        , args(alloc)
+        {}
+
+        const uint32_t* args_of(const Step& step) const { return args.data() + step.first_arg; }
+        // number of scheduled expressions
+        std::size_t size() const { return leaves.size() + steps.size(); }
+        bool empty() const { return leaves.empty() && steps.empty(); }
+
+        void clear()
+        {
+            leaves.clear();
+            steps.clear();
+            args.clear();
+        }
+
+        Expression root;
+        // modification count of the pool the schedule was built at
+        uint64_t modification = 0;
+        // how often the schedule of this root was built
+        std::size_t num_builds = 0;
+
+        vector_type<uint32_t> leaves;
+        vector_type<Step> steps;
+        vector_type<uint32_t> args;
+    };
+
+} // namespace v2
+} // namespace do_ast
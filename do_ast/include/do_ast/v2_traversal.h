@@ -0,0 +1,337 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace do_ast {
+namespace v2 {
+
+    enum class TraversalEvent
+    {
+        Pre,  // before the arguments
+        In,   // between two arguments, once for an expression without arguments
+        Post  // after the arguments
+    };
+
+    // orders of Traversal_
+    struct PreOrder {};
+    struct PostOrder {};
+
+    // events of an in order traversal, disabled events are left out at compile time
+    template<bool TPre, bool TIn, bool TPost>
+    struct InOrderEvents
+    {
+        using Pre = std::integral_constant<bool, TPre>;
+        using In = std::integral_constant<bool, TIn>;
+        using Post = std::integral_constant<bool, TPost>;
+    };
+
+    using AllInOrderEvents = InOrderEvents<true, true, true>;
+
+    template<class TEvents = AllInOrderEvents>
+    struct InOrder
+    {
+        using Events = TEvents;
+    };
+
+    template<class TExpressions, class TOrder>
+    struct Traversal_
+    {
+        // lazy traversal of an Expressions pool: each increment walks to the next expression, so a consumer
+        // that breaks out of the loop stops the walk. the stack lives in the TraversalContext.
+        //   for (const auto& item : exprs.pre_order(root, ctx)) { ... traversal.skip_children() ... }
+        // pre and post order visit the expressions below root, in order visits handles without expression
+        // too, with null pointers like traverse_in_order. the pool may not be modified during a traversal.
+        using Expressions = TExpressions;
+        using Order = TOrder;
+        using Expression = typename Expressions::Expression;
+        using TypeClass = typename Expressions::TypeClass;
+        // the relations column entry, or a view into the child arena with ArenaRelations_
+        using Relations = typename Expressions::RelationsView;
+        using Value = typename Expressions::Value;
+        using Context = typename Expressions::TraversalContext;
+
+        struct Item
+        {
+            int depth = 0;
+            Expression expr;
+            const TypeClass* type = nullptr;
+            const Relations* rel = nullptr;
+            const Value* value = nullptr;
+            TraversalEvent event = TraversalEvent::Pre;
+        };
+
+        struct iterator
+        {
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Item;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Item*;
+            using reference = const Item&;
+
+            Traversal_* traversal = nullptr;
+
+            reference operator*() const { return traversal->current(); }
+            pointer operator->() const { return &traversal->current(); }
+            iterator& operator++() { traversal->next(); return *this; }
+            // the end iterator has no traversal, any other compares equal to it once the traversal is done
+            friend bool operator==(const iterator& a, const iterator& b)
+            {
+                bool a_done = !a.traversal || a.traversal->done();
+                bool b_done = !b.traversal || b.traversal->done();
+                return a_done && b_done;
+            }
+            friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+        };
+
+        Traversal_(const Expressions& exprs, Expression root, Context& ctx)
+        : m_exprs(exprs)
+        , m_types(exprs.pool.template slots<0>().data())
+        , m_relations(exprs.relations())
+        , m_values(exprs.pool.template slots<2>())
+        , m_stack(ctx.stack)
+        {
+            m_stack.clear();
+            if (contains(root) || IsInOrder::value) m_stack.emplace_back(root, 0);
+            next();
+        }
+
+        // a copy would walk on the stack of the same context, and with a child arena item.rel points into
+        // the traversal. only moves are allowed, e.g. the return of pre_order, they redirect item.rel.
+        Traversal_(const Traversal_&) = delete;
+        Traversal_& operator=(const Traversal_&) = delete;
+        Traversal_(Traversal_&& other)
+        : m_exprs(other.m_exprs)
+        , m_types(other.m_types)
+        , m_relations(other.m_relations)
+        , m_view(other.m_view)
+        , m_values(other.m_values)
+        , m_stack(other.m_stack)
+        , m_item(other.m_item)
+        , m_started(other.m_started)
+        , m_skip(other.m_skip)
+        , m_done(other.m_done)
+        {
+            if (IsArena::value && m_item.rel) m_item.rel = relations_at(m_item.expr.index, IsArena());
+        }
+
+        iterator begin() { return iterator{this}; }
+        iterator end() { return iterator(); }
+
+        bool done() const { return m_done; }
+        const Item& current() const { return m_item; }
+        // advances to the next item, done() once all are visited
+        void next() { advance(Order()); }
+
+        // the arguments of the current expression that were not walked yet are skipped.
+        // pre order continues with the next sibling, in order with the Post event of the current expression.
+        void skip_children()
+        {
+            static_assert(!std::is_same<Order, PostOrder>::value, "post order visits an expression after its arguments.");
+            skip(Order());
+        }
+
+        // ends the traversal, done() afterwards
+        void stop()
+        {
+            m_stack.clear();
+            m_done = true;
+        }
+
+    protected:
+        using Frame = typename Context::Frame;
+        using IsArena = typename Expressions::RelationsReader::IsArena;
+        using IsInOrder = std::integral_constant<bool, !std::is_same<Order, PreOrder>::value && !std::is_same<Order, PostOrder>::value>;
+
+        // in order frame steps
+        using Enter = std::integral_constant<int, 0>;
+        using Args = std::integral_constant<int, 1>;
+        using Between = std::integral_constant<int, 2>;
+        using NextArg = std::integral_constant<int, 3>;
+        using Leave = std::integral_constant<int, 4>;
+
+        bool contains(Expression expr) const { return m_exprs.pool.contains(expr); }
+
+        void set_item(const Frame& frame, TraversalEvent event, bool valid = true)
+        {
+            auto idx = frame.expr.index;
+            m_item.depth = frame.depth;
+            m_item.expr = frame.expr;
+            m_item.type = valid ? &m_types[idx] : nullptr;
+            m_item.rel = valid ? relations_at(idx, IsArena()) : nullptr;
+            m_item.value = valid ? &m_values[idx] : nullptr;
+            m_item.event = event;
+        }
+
+        const Relations* relations_at(std::size_t idx, std::false_type) const { return &m_relations[idx]; }
+        const Relations* relations_at(std::size_t idx, std::true_type)
+        {
+            m_view = m_relations[idx];
+            return &m_view;
+        }
+
+        void advance(PreOrder)
+        {
+            // the arguments of the current expression are pushed when the traversal moves past it
+            if (m_started && !m_skip)
+            {
+                const auto& rel = *m_item.rel;
+                for (uint32_t k = 0; k < rel.num_args; ++k)
+                {
+                    auto arg = rel.args[rel.num_args-1-k];
+                    if (contains(arg)) m_stack.emplace_back(arg, m_item.depth+1);
+                }
+            }
+            m_started = true;
+            m_skip = false;
+            if (m_stack.empty())
+            {
+                m_done = true;
+                return;
+            }
+            auto frame = m_stack.back();
+            m_stack.pop_back();
+            set_item(frame, TraversalEvent::Pre);
+        }
+
+        void advance(PostOrder)
+        {
+            const auto& relations = m_relations;
+            while (!m_stack.empty())
+            {
+                auto idx_frame = m_stack.size()-1;
+                const auto& rel = relations[m_stack.back().expr.index];
+                if (m_stack.back().step || (rel.num_args == 0))
+                {
+                    set_item(m_stack.back(), TraversalEvent::Post);
+                    m_stack.pop_back();
+                    return;
+                }
+                auto new_depth = m_stack.back().depth + 1;
+                for (uint32_t k = 0; k < rel.num_args; ++k)
+                {
+                    auto arg = rel.args[rel.num_args-1-k];
+                    if (contains(arg)) m_stack.emplace_back(arg, new_depth);
+                }
+                m_stack[idx_frame].step = 1;
+            }
+            m_done = true;
+        }
+
+        template<class TEvents>
+        void advance(InOrder<TEvents>)
+        {
+            // runs the frame on top of the stack until it produces an enabled event.
+            // num_args of a frame is -1 for a handle without expression.
+            using Events = TEvents;
+            const auto& relations = m_relations;
+            while (!m_stack.empty())
+            {
+                auto& frame = m_stack.back();
+                switch (frame.step)
+                {
+                    case Enter::value:
+                    {
+                        frame.num_args = contains(frame.expr) ? static_cast<int>(relations[frame.expr.index].num_args) : -1;
+                        frame.step = Args::value;
+                        if (Events::Pre::value)
+                        {
+                            set_item(frame, TraversalEvent::Pre, frame.num_args >= 0);
+                            return;
+                        }
+                    }
+                    // falls through
+                    case Args::value:
+                    {
+                        if (frame.num_args <= 0)
+                        {
+                            frame.step = Leave::value;
+                            if (Events::In::value)
+                            {
+                                set_item(frame, TraversalEvent::In, frame.num_args == 0);
+                                // without Post event nothing is left to do for the frame
+                                if (!Events::Post::value) m_stack.pop_back();
+                                return;
+                            }
+                            break;
+                        }
+                        // the first argument follows without an In event
+                        push_next_arg(frame);
+                        continue;
+                    }
+                    case Between::value:
+                    {
+                        if (frame.processed_args < frame.num_args)
+                        {
+                            if (Events::In::value)
+                            {
+                                frame.step = NextArg::value;
+                                set_item(frame, TraversalEvent::In);
+                                return;
+                            }
+                            push_next_arg(frame);
+                            continue;
+                        }
+                        frame.step = Leave::value;
+                        break;
+                    }
+                    case NextArg::value:
+                    {
+                        push_next_arg(frame);
+                        continue;
+                    }
+                    default: break;
+                }
+                if (frame.step == Leave::value)
+                {
+                    auto done = frame;
+                    m_stack.pop_back();
+                    if (Events::Post::value)
+                    {
+                        set_item(done, TraversalEvent::Post, done.num_args >= 0);
+                        return;
+                    }
+                }
+            }
+            m_done = true;
+        }
+
+        void push_next_arg(Frame& frame)
+        {
+            // frame is not used after the push, it may reallocate the stack
+            auto arg = m_relations[frame.expr.index].args[frame.processed_args];
+            auto new_depth = frame.depth + 1;
+            ++frame.processed_args;
+            frame.step = Between::value;
+            m_stack.emplace_back(arg, new_depth);
+        }
+
+        void skip(PreOrder) { m_skip = true; }
+
+        template<class TEvents>
+        void skip(InOrder<TEvents>)
+        {
+            // the Pre and In events of an expression with arguments are produced while its frame is on top
+            // of the stack, a frame one level up belongs to the parent
+            if (m_done || (m_item.event == TraversalEvent::Post) || m_stack.empty()) return;
+            auto& frame = m_stack.back();
+            if (frame.depth == m_item.depth) frame.step = Leave::value;
+        }
+
+        const Expressions& m_exprs;
+        const TypeClass* m_types;
+        typename Expressions::RelationsReader m_relations;
+        // the view m_item.rel points to with a child arena
+        typename std::conditional<IsArena::value, Relations, char>::type m_view{};
+        // by reference, a Lazy value column is not materialized
+        const typename std::decay<decltype(std::declval<const Expressions&>().pool.template slots<2>())>::type& m_values;
+        decltype(Context::stack)& m_stack;
+        Item m_item;
+        bool m_started = false;
+        bool m_skip = false;
+        bool m_done = false;
+    };
+
+} // namespace v2
+} // namespace do_ast
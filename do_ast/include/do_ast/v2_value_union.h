@@ -4,8 +4,11 @@
 #include <cstdint>
 #include <type_traits>
 #include <string>
+#include <new>
+#include <utility>
 
 #include <do_ast/auto_padding.h>
+#include <do_ast/lazy_column.h>
 
 namespace do_ast {
 namespace v2 {
@@ -387,13 +390,28 @@ namespace v2 {
         ValueUnionBig(Type type) : type(type) {}
         ValueUnionBig(const ValueUnionBig& other)
         {
-            as_uint8 = other.as_uint8;
-            type = other.type;
+            copy_from(other);
+        }
+        ValueUnionBig(ValueUnionBig&& other) noexcept
+        {
+            move_from(other);
         }
         ValueUnionBig& operator=(const ValueUnionBig& other)
         {
-            as_uint8 = other.as_uint8;
-            type = other.type;
+            if (this != &other)
+            {
+                destroy();
+                copy_from(other);
+            }
+            return *this;
+        }
+        ValueUnionBig& operator=(ValueUnionBig&& other) noexcept
+        {
+            if (this != &other)
+            {
+                destroy();
+                move_from(other);
+            }
             return *this;
         }
         static ValueUnionBig Void    () { return ValueUnionBig(); }
@@ -409,9 +427,40 @@ namespace v2 {
         static ValueUnionBig Uint64  (uint64_t value)           { static_assert(sizeof(uint64_t   ) <= TMaxDataSize, "Uint64 not supported with this MaxDataSize.");  ValueUnionBig result(Type::Uint64);  result.as_uint64[0] = value;   return result;}
         static ValueUnionBig Float   (float    value)           { static_assert(sizeof(float      ) <= TMaxDataSize, "Float not supported with this MaxDataSize.");   ValueUnionBig result(Type::Float);   result.as_float[0] = value;    return result;}
         static ValueUnionBig Double  (double   value)           { static_assert(sizeof(double     ) <= TMaxDataSize, "Double not supported with this MaxDataSize.");  ValueUnionBig result(Type::Double);  result.as_double[0] = value;   return result;}
-        static ValueUnionBig String  (const std::string& value) { static_assert(sizeof(std::string) <= TMaxDataSize, "String not supported with this MaxDataSize.");  ValueUnionBig result(Type::String);  result.as_string = value;      return result;}
+        static ValueUnionBig String  (std::string value)        { static_assert(sizeof(std::string) <= TMaxDataSize, "String not supported with this MaxDataSize.");  ValueUnionBig result;                new (&result.as_string) ArrayOf<std::string>{{std::move(value)}}; result.type = Type::String; return result;}
         
         ~ValueUnionBig()
+        {
+            destroy();
+        }
+
+    protected:
+        // the strings are alive only while type is String, all other types are copied bytewise
+        void copy_from(const ValueUnionBig& other)
+        {
+            if (other.type == Type::String)
+            {
+                new (&as_string) ArrayOf<std::string>(other.as_string);
+            }
+            else
+            {
+                as_uint8 = other.as_uint8;
+            }
+            type = other.type;
+        }
+        void move_from(ValueUnionBig& other)
+        {
+            if (other.type == Type::String)
+            {
+                new (&as_string) ArrayOf<std::string>(std::move(other.as_string));
+            }
+            else
+            {
+                as_uint8 = other.as_uint8;
+            }
+            type = other.type;
+        }
+        void destroy()
         {
             if (type == Type::String)
             {
@@ -420,6 +469,7 @@ namespace v2 {
                     s.~basic_string();
                 }
             }
+            type = Type::Void;
         }
 
     };
@@ -447,4 +497,12 @@ namespace v2 {
     >;
 
 } // namespace v2
+
+    // a Lazy<ValueUnion> column stores only values that are not Void
+    template<class T>
+    struct LazyTraits<T, std::enable_if_t<std::is_same<typename T::Type, v2::ValueUnionType>::value>>
+    {
+        static bool is_empty(const T& value) { return value.type == v2::ValueUnionType::Void; }
+    };
+
 } // namespace do_ast
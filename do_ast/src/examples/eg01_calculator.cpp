@@ -12,6 +12,10 @@ struct Calculator
 {
     using Ast = do_ast::v1::Ast;
     using ItemPoolIndex = do_ast::ItemPoolIndex;
+    using ArgRange = Ast::ArgRange;
+    using StringRef = do_ast::StringRef;
+    using Walker = do_ast::v1::Walker;
+    using WalkAction = do_ast::v1::WalkAction;
     
     Ast ast;
 
@@ -38,6 +42,12 @@ struct Calculator
         return ast.create_with_value(Expr_Value::value, value);
     }
 
+    template<class Iterator>
+    do_ast::ItemPoolRange values(Iterator first, Iterator last)
+    {
+        return ast.create_with_values(Expr_Value::value, first, last);
+    }
+
     //template<class T>
     //ItemPoolIndex value(const T& value)
     //{
@@ -60,6 +70,11 @@ struct Calculator
     {
         return ast.create_with_args(Expr_Div::value, a, b);
     }
+    // one add over all args, the args are stored in the flat child arena of the ast
+    ItemPoolIndex add(const ItemPoolIndex* args, std::size_t num_args)
+    {
+        return ast.create_with_args(Expr_Add::value, args, num_args);
+    }
 
     struct PrintVisitor
     {
@@ -79,6 +94,16 @@ struct Calculator
         } 
         void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3) {} 
         void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3, ItemPoolIndex arg4) {} 
+        void with_arg_list(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ArgRange args) 
+        { 
+            std::cout << "(";
+            for (std::size_t k = 0; k < args.size(); ++k)
+            {
+                if (k > 0) std::cout << calc->str_expr_type[expr_type];
+                ast.visit(*this, args[k]);
+            }
+            std::cout << ")";
+        } 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type) {} 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, void* value) {} 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, bool value)     { std::cout << value; } 
@@ -92,8 +117,81 @@ struct Calculator
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint64_t value) { std::cout << value; } 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, float value)    { std::cout << value; } 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, double value)   { std::cout << value; } 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, const std::string& value) {} 
+        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, StringRef value) {} 
     };    
+
+    double value_of(const Ast::Expression& expr) const
+    {
+        if (const auto* value = ast.value<double>(expr)) return *value;
+        if (const auto* value = ast.value<float>(expr)) return *value;
+        if (const auto* value = ast.value<int32_t>(expr)) return *value;
+        return 0;
+    }
+
+    Ast::FoldContext<double> fold_ctx;
+
+    // evaluation by fold: the results of the args arrive as a range, fold_ctx is reused between evaluations
+    double evaluate(ItemPoolIndex root)
+    {
+        return ast.fold<double>(root,
+            [this](ItemPoolIndex expr_idx, const Ast::Expression& expr) { return value_of(expr); },
+            [](ItemPoolIndex expr_idx, const Ast::Expression& expr, do_ast::v1::ArgRange_<double> results)
+            {
+                auto eval = results[0];
+                for (std::size_t k = 1; k < results.size(); ++k)
+                {
+                    switch (expr.expr_type)
+                    {
+                        case Expr_Add::value: eval += results[k]; break;
+                        case Expr_Sub::value: eval -= results[k]; break;
+                        case Expr_Mul::value: eval *= results[k]; break;
+                        case Expr_Div::value: eval /= results[k]; break;
+                    }
+                }
+                return eval;
+            },
+            fold_ctx);
+    }
+
+    struct WalkEvaluator
+    {
+        // EvaluationVisitor without recursion, walker and stack are reused between evaluations
+        WalkEvaluator(Calculator& calc) : calc(&calc) {}
+
+        Calculator* calc;
+        Walker walker;
+        std::vector<double> stack;
+
+        double operator()(ItemPoolIndex root)
+        {
+            stack.clear();
+            walker.walk_post_order(calc->ast, root, [this](ItemPoolIndex expr_idx, const Ast::Expression& expr, ArgRange args)
+            {
+                if (args.empty())
+                {
+                    stack.push_back(calc->value_of(expr));
+                    return WalkAction::Continue;
+                }
+                auto first = stack.end() - args.size();
+                auto eval = *first;
+                for (auto it = first + 1; it != stack.end(); ++it)
+                {
+                    switch (expr.expr_type)
+                    {
+                        case Expr_Add::value: eval += *it; break;
+                        case Expr_Sub::value: eval -= *it; break;
+                        case Expr_Mul::value: eval *= *it; break;
+                        case Expr_Div::value: eval /= *it; break;
+                    }
+                }
+                stack.resize(stack.size() - args.size() + 1);
+                stack.back() = eval;
+                return WalkAction::Continue;
+            });
+            return stack.back();
+        }
+    };
+
     struct EvaluationVisitor
     {
         EvaluationVisitor(Calculator& calc) : calc(&calc) {}
@@ -121,6 +219,26 @@ struct Calculator
         } 
         void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3) {} 
         void with_args(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ItemPoolIndex arg1, ItemPoolIndex arg2, ItemPoolIndex arg3, ItemPoolIndex arg4) {} 
+        void with_arg_list(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, ArgRange args) 
+        { 
+            // left fold over the args
+            if (args.empty()) return;
+            ast.visit(*this, args[0]);
+            auto eval = stack.back(); stack.pop_back();
+            for (std::size_t k = 1; k < args.size(); ++k)
+            {
+                ast.visit(*this, args[k]);
+                auto eval_k = stack.back(); stack.pop_back();
+                switch (expr_type)
+                {
+                    case Expr_Add::value: eval += eval_k; break;
+                    case Expr_Sub::value: eval -= eval_k; break;
+                    case Expr_Mul::value: eval *= eval_k; break;
+                    case Expr_Div::value: eval /= eval_k; break;
+                }
+            }
+            stack.push_back(eval);
+        } 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type) {} 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, void* value) {} 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, bool value)     { stack.push_back(value); } 
@@ -134,7 +252,7 @@ struct Calculator
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, uint64_t value) { stack.push_back(value); } 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, float value)    { stack.push_back(value); } 
         void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, double value)   { stack.push_back(value); } 
-        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, const std::string& value) {} 
+        void with_value(Ast& ast, ItemPoolIndex expr_idx, uint32_t expr_type, StringRef value) {} 
     };    
 };
 
@@ -161,9 +279,10 @@ do_ast::ItemPoolIndex mk_long_add(Calculator& calc, T begin, T end)
     {
         static std::vector<do_ast::ItemPoolIndex> s_exprs;
         s_exprs.clear();
+        auto leaves = calc.values(begin, end);
         for(uint32_t idx = 0; idx < count; idx++)
         {
-            s_exprs.push_back(calc.value(begin[idx]));
+            s_exprs.push_back(leaves[idx]);
         }
         uint32_t last_start = 0;
         uint32_t last_count = s_exprs.size();
@@ -249,6 +368,97 @@ int main(int argc, char **argv)
     std::chrono::duration<double> d0 = t1-t0;
     double fps0 = abs(d0.count()) > 1e-12 ? (num_it / d0.count()) : 0;
     std::cout << "phase0: " << (d0.count() / num_it) * 1000 << " ms " << fps0 << " fps\n";
-    std::cout << " sum " << sum;
+    std::cout << " sum " << sum << "\n";
+
+    Calculator::WalkEvaluator walk_eval(calc);
+    t0 = std::chrono::system_clock::now();
+    sum = 0;
+    for (int i=0; i<num_it; ++i)
+    {
+        sum += walk_eval(b);
+    }
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d0w = t1-t0;
+    double fps0w = abs(d0w.count()) > 1e-12 ? (num_it / d0w.count()) : 0;
+    std::cout << "phase0 (walker): " << (d0w.count() / num_it) * 1000 << " ms " << fps0w << " fps\n";
+    std::cout << " sum " << sum << "\n";
+
+    t0 = std::chrono::system_clock::now();
+    sum = 0;
+    for (int i=0; i<num_it; ++i)
+    {
+        sum += calc.evaluate(b);
+    }
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d0f = t1-t0;
+    double fps0f = abs(d0f.count()) > 1e-12 ? (num_it / d0f.count()) : 0;
+    std::cout << "phase0 (fold): " << (d0f.count() / num_it) * 1000 << " ms " << fps0f << " fps\n";
+    std::cout << " sum " << sum << "\n";
+
+    // the same sum as a single add with all values as args
+    auto leaves = calc.values(values.begin(), values.end());
+    std::vector<do_ast::ItemPoolIndex> args;
+    args.reserve(leaves.size());
+    for (std::size_t k = 0; k < leaves.size(); ++k)
+    {
+        args.push_back(leaves[k]);
+    }
+    auto c = calc.add(args.data(), args.size());
+
+    t0 = std::chrono::system_clock::now();
+    sum = 0;
+    for (int i=0; i<num_it; ++i)
+    {
+        Calculator::EvaluationVisitor eval(calc);
+        calc.ast.visit(eval, c);
+        sum += eval.stack.back();
+    }
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d1 = t1-t0;
+    double fps1 = abs(d1.count()) > 1e-12 ? (num_it / d1.count()) : 0;
+    std::cout << "phase1 (arg list): " << (d1.count() / num_it) * 1000 << " ms " << fps1 << " fps\n";
+    std::cout << " sum " << sum << "\n";
+
+    t0 = std::chrono::system_clock::now();
+    sum = 0;
+    for (int i=0; i<num_it; ++i)
+    {
+        sum += walk_eval(c);
+    }
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d1w = t1-t0;
+    double fps1w = abs(d1w.count()) > 1e-12 ? (num_it / d1w.count()) : 0;
+    std::cout << "phase1 (arg list, walker): " << (d1w.count() / num_it) * 1000 << " ms " << fps1w << " fps\n";
+    std::cout << " sum " << sum << "\n";
+
+    t0 = std::chrono::system_clock::now();
+    sum = 0;
+    for (int i=0; i<num_it; ++i)
+    {
+        sum += calc.evaluate(c);
+    }
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d1f = t1-t0;
+    double fps1f = abs(d1f.count()) > 1e-12 ? (num_it / d1f.count()) : 0;
+    std::cout << "phase1 (arg list, fold): " << (d1f.count() / num_it) * 1000 << " ms " << fps1f << " fps\n";
+    std::cout << " sum " << sum << "\n";
+
+    // a chain of 1M nested adds, too deep for the recursive visitors
+    auto chain = calc.value(0.0);
+    for (int i=0; i<1024*1024; ++i)
+    {
+        chain = calc.add(chain, calc.value(1.0));
+    }
+    std::cout << "chain = " << walk_eval(chain) << " (walker) " << calc.evaluate(chain) << " (fold)\n";
+
+    // early exit: first value of at least 1000 in pre order
+    double found = 0;
+    walk_eval.walker.walk_pre_order(calc.ast, b, [&](do_ast::ItemPoolIndex expr_idx, const Calculator::Ast::Expression& expr, Calculator::ArgRange args)
+    {
+        if (!args.empty()) return WalkAction::Continue;
+        found = calc.value_of(expr);
+        return (found >= 1000) ? WalkAction::Stop : WalkAction::Continue;
+    });
+    std::cout << "first value >= 1000: " << found;
     return 0;
 }
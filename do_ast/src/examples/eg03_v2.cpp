@@ -210,7 +210,8 @@ int main(int argc, char **argv)
     using ScalarType = int32_t;
     // using ScalarType = float;
     std::vector<ScalarType> values_stack;
-    auto EvaluateAdd = [&exprs, &values_stack](auto expr) -> ScalarType {
+    Expressions::TraversalContext traversal_ctx;
+    auto EvaluateAdd = [&exprs, &values_stack, &traversal_ctx](auto expr) -> ScalarType {
         values_stack.clear();
         exprs.traverse_post_order(expr, [&values_stack](auto depth, auto expr_id, auto& type, auto& rel, auto& val){
             if (type == 0)
@@ -228,7 +229,7 @@ int main(int argc, char **argv)
                 values_stack.resize(1 + values_stack.size() - rel.num_args);
                 values_stack.back() = sum;
             }
-        });
+        }, traversal_ctx);
         return values_stack.back();
     };
 
@@ -302,6 +303,38 @@ int main(int argc, char **argv)
     auto expr = expressions.back();
     // PrintInOrder(expr);
 
+    // aligned copy of the value column for phase4, slot i holds the int32 value of expression slot i
+    ItemPoolTuple_<ItemPoolPolicy<AlignedStorage<64>>, ScalarType> scalars;
+    for (std::size_t i = 0; i < exprs.pool.size(); ++i)
+    {
+        scalars.insert(exprs.pool.get<2>(exprs.pool.index(i)).as_int32[0]);
+    }
+    // the reduction levels are runs of ops with contiguous results over contiguous argument pairs.
+    // count 0 marks a single op with unrelated arguments.
+    struct PairRun
+    {
+        uint32_t res;
+        uint32_t lhs;
+        uint32_t rhs;
+        uint32_t count;
+    };
+    std::vector<PairRun> runs;
+    for (const auto& op : operations_expr)
+    {
+        if (op.rhs != op.lhs + 1)
+        {
+            runs.push_back({op.res, op.lhs, op.rhs, 0});
+        }
+        else if (!runs.empty() && (runs.back().count > 0) && (op.res == runs.back().res + runs.back().count) && (op.lhs == runs.back().lhs + 2 * runs.back().count))
+        {
+            ++runs.back().count;
+        }
+        else
+        {
+            runs.push_back({op.res, op.lhs, op.rhs, 1});
+        }
+    }
+
 
     std::cout << "=" << EvaluateAdd(expr) << "\n";
     
@@ -375,24 +408,117 @@ int main(int argc, char **argv)
     
     auto t4 = std::chrono::system_clock::now();
 
+    ScalarType sum4 = 0;
+    for (int i=0; i<num_it; ++i)
+    {
+        // runs are processed in whole blocks of 8 results reading 64 bytes of arguments.
+        // the extra lanes land on results of later ops, which are recomputed afterwards, or in the padding past the column.
+        auto* values = scalars.slots<0>().data();
+        for (const auto& run : runs)
+        {
+            if (run.count == 0)
+            {
+                values[run.res] = values[run.lhs] + values[run.rhs];
+                continue;
+            }
+            ScalarType* __restrict res = values + run.res;
+            const ScalarType* __restrict args = values + run.lhs;
+            auto num_blocks = (run.count + 7) / 8;
+            for (uint32_t k = 0; k < num_blocks * 8; ++k)
+            {
+                res[k] = args[2*k] + args[2*k+1];
+            }
+        }
+        sum4 += values[expressions.back().index];
+    }
+
+    auto t5 = std::chrono::system_clock::now();
+
+    // the cached schedule of expr, built by the first call and looked up by the others.
+    // it is the operations_expr list of phase2 without building it by hand.
+    ScalarType sum5 = 0;
+    for (int i=0; i<num_it; ++i)
+    {
+        const auto& schedule = exprs.schedule(expr);
+        const auto* args = schedule.args.data();
+        auto* values = exprs.pool.slots<2>().data();
+        for (const auto& step : schedule.steps)
+        {
+            // every step has at least one argument
+            const auto* step_args = args + step.first_arg;
+            ScalarType sum = values[step_args[0]].as_int32[0];
+            for (uint32_t k = 1; k < step.num_args; ++k)
+            {
+                sum += values[step_args[k]].as_int32[0];
+            }
+            values[step.slot].as_int32[0] = sum;
+        }
+        sum5 += values[expr.index].as_int32[0];
+    }
+
+    auto t6 = std::chrono::system_clock::now();
+
     // double dnorm = static_cast<double>(operations.size() * num_it); 
     double dnorm = static_cast<double>(num_it); 
     std::chrono::duration<double> d0 = t1-t0;
     std::chrono::duration<double> d1 = t2-t1;
     std::chrono::duration<double> d2 = t3-t2;
     std::chrono::duration<double> d3 = t4-t3;
+    std::chrono::duration<double> d4 = t5-t4;
+    std::chrono::duration<double> d5 = t6-t5;
     double fps0 = abs(d0.count()) > 1e-12 ? (dnorm / d0.count()) : 0;
     double fps1 = abs(d1.count()) > 1e-12 ? (dnorm / d1.count()) : 0;
     double fps2 = abs(d2.count()) > 1e-12 ? (dnorm / d2.count()) : 0;
     double fps3 = abs(d3.count()) > 1e-12 ? (dnorm / d3.count()) : 0;
+    double fps4 = abs(d4.count()) > 1e-12 ? (dnorm / d4.count()) : 0;
+    double fps5 = abs(d5.count()) > 1e-12 ? (dnorm / d5.count()) : 0;
     std::cout << "phase0: " << (d0.count() / dnorm) * 1000 << " ms " << fps0 << " fps\n";
     std::cout << "phase1: " << (d1.count() / dnorm) * 1000 << " ms " << fps1 << " fps\n";
     std::cout << "phase2: " << (d2.count() / dnorm) * 1000 << " ms " << fps2 << " fps\n";
     std::cout << "phase3: " << (d3.count() / dnorm) * 1000 << " ms " << fps3 << " fps\n";
+    std::cout << "phase4: " << (d4.count() / dnorm) * 1000 << " ms " << fps4 << " fps\n";
+    std::cout << "phase5: " << (d5.count() / dnorm) * 1000 << " ms " << fps5 << " fps\n";
     std::cout << " sum0 " << sum0 << "\n";
     std::cout << " sum1 " << sum1 << "\n";
     std::cout << " sum2 " << sum2 << "\n";
     std::cout << " sum3 " << sum3 << "\n";
+    std::cout << " sum4 " << sum4 << "\n";
+    std::cout << " sum5 " << sum5 << "\n";
+
+    std::cout << "---" << "\n";
+
+    // the schedule is rebuilt only after the structure changed, writing a leaf value keeps it
+    {
+        auto builds = [&exprs, &expr]() { return exprs.schedule(expr).num_builds; };
+        std::cout << "schedule of " << exprs.schedule(expr).size() << " expressions, builds " << builds() << "\n";
+        exprs.pool.get<2>(expressions[0]).as_int32[0] += 1;
+        std::cout << "after a value write, builds " << builds() << "\n";
+        auto lhs = exprs.pool.get<1>(expr).args[0];
+        auto rhs = exprs.pool.get<1>(expr).args[1];
+        exprs.set_relations(expr, Relations(lhs, rhs, expressions[0]));
+        auto t_build0 = std::chrono::system_clock::now();
+        auto num_builds = builds();
+        auto t_build1 = std::chrono::system_clock::now();
+        std::chrono::duration<double> d_build = t_build1-t_build0;
+        std::cout << "after set_relations, builds " << num_builds << " in " << d_build.count() * 1000 << " ms\n";
+        exprs.set_relations(expr, Relations(lhs, rhs));
+        exprs.pool.get<2>(expressions[0]).as_int32[0] -= 1;
+    }
+
+    std::cout << "---" << "\n";
+
+    // the same expressions with the value column as Lazy<Value>, only the leaves store a value
+    {
+        v2::Expressions<uint32_t, Relations, Lazy<Value>> lazy_exprs;
+        for (std::size_t i = 0; i < exprs.pool.size(); ++i)
+        {
+            auto idx = exprs.pool.index(i);
+            lazy_exprs.insert(exprs.pool.get<0>(idx), exprs.pool.get<1>(idx), exprs.pool.get<2>(idx));
+        }
+        std::cout << "expressions " << exprs.pool.size() << " values " << lazy_exprs.pool.slots<2>().num_values() << "\n";
+        std::cout << "dense columns: " << exprs.pool.columns_bytes() << " bytes, value column " << column_bytes(exprs.pool.slots<2>()) << " bytes\n";
+        std::cout << "lazy columns:  " << lazy_exprs.pool.columns_bytes() << " bytes, value column " << column_bytes(lazy_exprs.pool.slots<2>()) << " bytes\n";
+    }
 
     std::cout << "---" << "\n";
 
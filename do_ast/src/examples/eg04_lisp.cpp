@@ -8,9 +8,11 @@
 
 namespace do_ast {
 
-    struct Lisp
+    // TValue = Lazy<...> keeps the values of the value nodes only
+    template<class TValue = v2::ValueUnion<sizeof(double)>>
+    struct Lisp_
     {
-        using Expressions = do_ast::v2::Expressions<>;
+        using Expressions = do_ast::v2::Expressions<uint32_t, v2::Relations_<ItemPoolIndex, 4>, TValue>;
         using Expression = typename Expressions::Expression;
         using Relations = typename Expressions::Relations;
         using Value = typename Expressions::Value;
@@ -91,6 +93,8 @@ namespace do_ast {
 
     };
 
+    using Lisp = Lisp_<>;
+
 } // namespace do_ast
 
 
@@ -112,5 +116,16 @@ int main(int argc, char **argv)
     std::cout << lisp.to_string_prefix(list3) << "\n";
     std::cout << lisp.to_string_prefix(list4) << "\n";
 
+    // memory of a long list with dense and with lazy values
+    std::vector<int32_t> numbers(16*1024);
+    for (std::size_t i = 0; i < numbers.size(); ++i) numbers[i] = static_cast<int32_t>(i);
+    Lisp dense_lisp;
+    Lisp_<Lazy<Lisp::Value>> lazy_lisp;
+    dense_lisp.list(numbers);
+    lazy_lisp.list(numbers);
+    std::cout << "expressions " << dense_lisp.exprs.pool.size() << "\n";
+    std::cout << "dense columns: " << dense_lisp.exprs.pool.columns_bytes() << " bytes, value column " << column_bytes(dense_lisp.exprs.pool.slots<2>()) << " bytes\n";
+    std::cout << "lazy columns:  " << lazy_lisp.exprs.pool.columns_bytes() << " bytes, value column " << column_bytes(lazy_lisp.exprs.pool.slots<2>()) << " bytes\n";
+
     return 0;
 }
@@ -0,0 +1,139 @@
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "mk_reduction.h"
+#include <do_ast/item_pool.h>
+#include <do_ast/item_pool_tuple.h>
+#include <do_ast/v1_ast.h>
+#include <do_ast/v2.h>
+
+// compares build time and peak RSS of the vector and segmented slot storage.
+// peak RSS is a per process value, run once per backend for a clean comparison:
+//   do_ast_eg07_segmented_storage vector
+//   do_ast_eg07_segmented_storage segmented
+
+double peak_rss_mb()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+template<class TPolicy>
+double build_v1_long_add(uint32_t num_values, const std::vector<Operation>& ops, int num_it)
+{
+    using namespace do_ast;
+    using namespace do_ast::v1;
+
+    double checksum = 0;
+    for (int it = 0; it < num_it; ++it)
+    {
+        ItemPool<Expression, TPolicy> expr_pool;
+        ItemPool<ArgExpressionList<2>, TPolicy> arg_expr_list_2_pool;
+        ItemPool<ArgValue<double>, TPolicy> arg_value_double_pool;
+
+        std::vector<ItemPoolIndex> exprs;
+        exprs.reserve(num_values + ops.size());
+        for (uint32_t i = 0; i < num_values; ++i)
+        {
+            exprs.push_back(expr_pool.emplace(0, 0x80000000 + 12, arg_value_double_pool.emplace(static_cast<double>(i))));
+        }
+        for (const auto& op : ops)
+        {
+            auto args = arg_expr_list_2_pool.insert({exprs[op.lhs], exprs[op.rhs]});
+            exprs.push_back(expr_pool.emplace(1, 2, args));
+        }
+        checksum += expr_pool.size() + arg_expr_list_2_pool.size() + arg_value_double_pool.size();
+    }
+    return checksum;
+}
+
+template<class TPolicy>
+double build_v2_long_add(uint32_t num_values, const std::vector<Operation>& ops, int num_it)
+{
+    using namespace do_ast;
+    using Relations = v2::Relations_<ItemPoolIndex, 4>;
+    using Value = v2::ValueUnion<sizeof(double)>;
+
+    double checksum = 0;
+    for (int it = 0; it < num_it; ++it)
+    {
+        ItemPoolTuple_<TPolicy, uint32_t, Relations, Value> pool;
+
+        std::vector<ItemPoolIndex> exprs;
+        exprs.reserve(num_values + ops.size());
+        for (uint32_t i = 0; i < num_values; ++i)
+        {
+            exprs.push_back(pool.insert(0, Relations(), Value::Double(i)));
+        }
+        for (const auto& op : ops)
+        {
+            exprs.push_back(pool.insert(1, Relations(exprs[op.lhs], exprs[op.rhs]), Value::Void()));
+        }
+        checksum += pool.size();
+    }
+    return checksum;
+}
+
+template<class TPolicy>
+void run(const std::string& name, uint32_t num_values, const std::vector<Operation>& ops, int num_it)
+{
+    auto t0 = std::chrono::system_clock::now();
+    double sum0 = build_v1_long_add<TPolicy>(num_values, ops, num_it);
+    auto t1 = std::chrono::system_clock::now();
+    double sum1 = build_v2_long_add<TPolicy>(num_values, ops, num_it);
+    auto t2 = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> d0 = t1-t0;
+    std::chrono::duration<double> d1 = t2-t1;
+    std::cout << name << "\n";
+    std::cout << "  v1 pools build: " << (d0.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  v2 tuple build: " << (d1.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  peak rss:       " << peak_rss_mb() << " MB\n";
+    std::cout << "  sum0 " << sum0 << " sum1 " << sum1 << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    using namespace do_ast;
+
+    std::string backend = (argc > 1) ? argv[1] : "";
+
+    std::vector<Operation> ops;
+    uint32_t num_values = 1024*1024;
+    mk_reduction(num_values, ops);
+    int num_it = 16;
+
+    std::cout << "leaves " << num_values << " nodes " << (num_values + ops.size()) << "\n";
+
+    if (backend.empty() || backend == "vector")
+    {
+        run<ItemPoolPolicy<VectorStorage>>("vector", num_values, ops, num_it);
+    }
+    if (backend.empty() || backend == "segmented")
+    {
+        run<ItemPoolPolicy<SegmentedStorage<>>>("segmented", num_values, ops, num_it);
+    }
+    return 0;
+}
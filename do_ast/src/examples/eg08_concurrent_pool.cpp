@@ -0,0 +1,123 @@
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+
+#include <do_ast/item_pool.h>
+#include <do_ast/concurrent_item_pool.h>
+
+// compares parallel insert / erase / lookup throughput of a mutex guarded ItemPool
+// and the lock-free ConcurrentItemPool for 1..N threads.
+//   do_ast_eg08_concurrent_pool [max_threads]
+
+struct Node
+{
+    uint32_t type;
+    uint32_t num_args;
+    double value;
+};
+
+struct LockedItemPool
+{
+    do_ast::ItemPool<Node> pool;
+    std::mutex mutex;
+
+    do_ast::ItemPoolIndex insert(const Node& node)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pool.insert(node);
+    }
+    void erase(do_ast::ItemPoolIndex idx)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pool.erase(idx);
+    }
+    double value(do_ast::ItemPoolIndex idx)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pool.contains(idx) ? pool.get(idx).value : 0;
+    }
+};
+
+struct LockFreeItemPool
+{
+    do_ast::ConcurrentItemPool<Node> pool;
+
+    do_ast::ItemPoolIndex insert(const Node& node) { return pool.insert(node); }
+    void erase(do_ast::ItemPoolIndex idx) { pool.erase(idx); }
+    double value(do_ast::ItemPoolIndex idx) { return pool.contains(idx) ? pool.get(idx).value : 0; }
+};
+
+template<class TPool>
+void worker(TPool& pool, uint32_t thread_id, uint32_t num_ops, double& checksum)
+{
+    // every thread builds nodes, looks them up and erases every second one again
+    std::vector<do_ast::ItemPoolIndex> nodes;
+    nodes.reserve(num_ops);
+    double sum = 0;
+    for (uint32_t i = 0; i < num_ops; ++i)
+    {
+        nodes.push_back(pool.insert(Node{thread_id, 0, static_cast<double>(i)}));
+        if (i % 2 == 1)
+        {
+            sum += pool.value(nodes[i-1]);
+            pool.erase(nodes[i-1]);
+        }
+    }
+    for (const auto& node : nodes)
+    {
+        sum += pool.value(node);
+    }
+    checksum = sum;
+}
+
+template<class TPool>
+double run(uint32_t num_threads, uint32_t num_ops, double& checksum)
+{
+    TPool pool;
+    std::vector<double> checksums(num_threads, 0);
+    std::vector<std::thread> threads;
+
+    auto t0 = std::chrono::system_clock::now();
+    for (uint32_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&pool, &checksums, t, num_ops]() { worker(pool, t, num_ops, checksums[t]); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto t1 = std::chrono::system_clock::now();
+
+    checksum = 0;
+    for (auto sum : checksums) checksum += sum;
+    checksum += pool.pool.size();
+
+    std::chrono::duration<double> d = t1-t0;
+    return d.count() * 1000;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t max_threads = (argc > 1) ? static_cast<uint32_t>(std::stoul(argv[1])) : std::thread::hardware_concurrency();
+    if (max_threads == 0) max_threads = 4;
+    uint32_t total_ops = 4*1024*1024;
+
+    std::cout << "total ops " << total_ops << "\n";
+    for (uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        uint32_t num_ops = total_ops / num_threads;
+        double sum0, sum1;
+        double d0 = run<LockedItemPool>(num_threads, num_ops, sum0);
+        double d1 = run<LockFreeItemPool>(num_threads, num_ops, sum1);
+        std::cout << "threads " << num_threads << "\n";
+        std::cout << "  mutex ItemPool:     " << d0 << " ms\n";
+        std::cout << "  ConcurrentItemPool: " << d1 << " ms\n";
+        std::cout << "  sum0 " << sum0 << " sum1 " << sum1 << "\n";
+    }
+    return 0;
+}
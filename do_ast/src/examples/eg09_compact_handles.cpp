@@ -0,0 +1,93 @@
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+
+#include "mk_reduction.h"
+#include <do_ast/item_pool_index.h>
+#include <do_ast/v1_ast.h>
+#include <do_ast/v2.h>
+
+// compares the default 16 byte ItemPoolIndex with packed handles of 8 and 4 bytes.
+// builds and traverses a reduction tree in v1::Ast_ and v2::Expressions.
+
+template<class TIndex>
+void run(const std::string& name, uint32_t num_values, const std::vector<Operation>& ops, int num_it)
+{
+    using namespace do_ast;
+    using Policy = ItemPoolPolicy<VectorStorage, TIndex>;
+    using Ast = v1::Ast_<Policy>;
+    using Relations = v2::Relations_<TIndex, 4>;
+    using Expressions = v2::Expressions<uint32_t, Relations, v2::ValueUnion<sizeof(double)>, Policy>;
+    using Value = typename Expressions::Value;
+
+    double sum_v1 = 0;
+    double sum_v2 = 0;
+    std::chrono::duration<double> d_v1(0);
+    std::chrono::duration<double> d_v2(0);
+    for (int it = 0; it < num_it; ++it)
+    {
+        auto t0 = std::chrono::system_clock::now();
+        {
+            Ast ast;
+            std::vector<TIndex> exprs;
+            exprs.reserve(num_values + ops.size());
+            for (uint32_t i = 0; i < num_values; ++i)
+            {
+                exprs.push_back(ast.create_with_value(0, static_cast<double>(i)));
+            }
+            for (const auto& op : ops)
+            {
+                exprs.push_back(ast.create_with_args(1, exprs[op.lhs], exprs[op.rhs]));
+            }
+            sum_v1 += exprs.back().index;
+        }
+        auto t1 = std::chrono::system_clock::now();
+        {
+            Expressions expressions;
+            std::vector<TIndex> exprs;
+            exprs.reserve(num_values + ops.size());
+            for (uint32_t i = 0; i < num_values; ++i)
+            {
+                exprs.push_back(expressions.insert(0, Relations(), Value::Double(i)));
+            }
+            for (const auto& op : ops)
+            {
+                exprs.push_back(expressions.insert(1, Relations(exprs[op.lhs], exprs[op.rhs])));
+            }
+            expressions.traverse_post_order(exprs.back(), [&sum_v2](int depth, TIndex expr, uint32_t type, const Relations& rel, const Value& value)
+            {
+                if (type == 0) sum_v2 += value.as_double[0];
+            });
+        }
+        auto t2 = std::chrono::system_clock::now();
+        d_v1 += t1-t0;
+        d_v2 += t2-t1;
+    }
+
+    std::cout << name << "\n";
+    std::cout << "  sizeof(Index) " << sizeof(TIndex)
+              << " sizeof(ArgExpressionList<4>) " << sizeof(typename Ast::template ArgExpressionList<4>)
+              << " sizeof(Relations) " << sizeof(Relations) << "\n";
+    std::cout << "  v1 build:          " << (d_v1.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  v2 build+traverse: " << (d_v2.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  sum_v1 " << sum_v1 << " sum_v2 " << sum_v2 << "\n";
+}
+
+int main()
+{
+    using namespace do_ast;
+
+    std::vector<Operation> ops;
+    uint32_t num_values = 1024*1024;
+    mk_reduction(num_values, ops);
+    int num_it = 8;
+
+    std::cout << "leaves " << num_values << " nodes " << (num_values + ops.size()) << "\n";
+
+    run<ItemPoolIndex>("ItemPoolIndex", num_values, ops, num_it);
+    run<ItemPoolIndex32>("ItemPoolIndex32", num_values, ops, num_it);
+    run<ItemPoolIndex24>("ItemPoolIndex24", num_values, ops, num_it);
+    return 0;
+}
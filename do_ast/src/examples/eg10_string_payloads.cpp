@@ -0,0 +1,126 @@
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <new>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v1_ast.h>
+#include <do_ast/v2.h>
+
+// counts heap allocations per insert on string heavy trees.
+// leaves carry strings too long for the small string optimization.
+// v2 stores a std::string per leaf, handing it over by move costs no allocation, by copy exactly one.
+// v1 copies each distinct string once into its string arena, repeated identifiers cost nothing.
+
+static uint64_t num_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++num_allocations;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+std::vector<std::string> mk_names(uint32_t num_values, uint32_t num_distinct)
+{
+    std::vector<std::string> names;
+    names.reserve(num_values);
+    for (uint32_t i = 0; i < num_values; ++i)
+    {
+        names.push_back("identifier_with_a_long_name_" + std::to_string(i % num_distinct));
+    }
+    return names;
+}
+
+template<class Build>
+void measure(const std::string& name, uint32_t num_values, uint32_t num_distinct, const std::vector<Operation>& ops, Build build)
+{
+    auto names = mk_names(num_values, num_distinct);
+    auto num_inserts = num_values + ops.size();
+
+    auto t0 = std::chrono::system_clock::now();
+    auto allocations_before = num_allocations;
+    double checksum = build(names);
+    auto allocations = num_allocations - allocations_before;
+    auto t1 = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> d = t1-t0;
+    std::cout << name << "\n";
+    std::cout << "  time:               " << d.count() * 1000 << " ms\n";
+    std::cout << "  allocations/insert: " << static_cast<double>(allocations) / num_inserts << "\n";
+    std::cout << "  checksum " << checksum << "\n";
+}
+
+int main()
+{
+    using namespace do_ast;
+    using Ast = v1::Ast;
+    using Relations = v2::Relations_<ItemPoolIndex, 4>;
+    using Expressions = v2::Expressions<uint32_t, Relations, v2::ValueUnion<sizeof(std::string)>>;
+    using Value = typename Expressions::Value;
+
+    std::vector<Operation> ops;
+    uint32_t num_values = 256*1024;
+    mk_reduction(num_values, ops);
+
+    std::cout << "leaves " << num_values << " nodes " << (num_values + ops.size()) << "\n";
+
+    // the node handles are kept in preallocated vectors, so only the pools allocate.
+    // pool growth adds a logarithmic number of allocations.
+    std::vector<ItemPoolIndex> exprs;
+    exprs.reserve(num_values + ops.size());
+
+    for (uint32_t num_distinct : {num_values, 1024u})
+    {
+        std::cout << "distinct names " << num_distinct << "\n";
+        std::size_t arena_strings = 0;
+        std::size_t arena_bytes = 0;
+        measure("v1 string arena", num_values, num_distinct, ops, [&](std::vector<std::string>& names) {
+            Ast ast;
+            exprs.clear();
+            for (const auto& name : names) exprs.push_back(ast.create_with_value(0, name));
+            for (const auto& op : ops) exprs.push_back(ast.create_with_args(1, exprs[op.lhs], exprs[op.rhs]));
+            arena_strings = ast.strings().size();
+            arena_bytes = ast.strings().bytes_used();
+            return static_cast<double>(exprs.back().index);
+        });
+        std::cout << "  arena: " << arena_strings << " strings, " << arena_bytes << " bytes\n";
+        measure("v1 symbols", num_values, num_distinct, ops, [&](std::vector<std::string>& names) {
+            // a front end that keeps symbols instead of strings, identifier equality is an integer compare
+            Ast ast;
+            exprs.clear();
+            for (const auto& name : names) exprs.push_back(ast.create_with_symbol(0, ast.strings().intern(name)));
+            for (const auto& op : ops) exprs.push_back(ast.create_with_args(1, exprs[op.lhs], exprs[op.rhs]));
+            return static_cast<double>(exprs.back().index);
+        });
+        measure("v2 copy", num_values, num_distinct, ops, [&](std::vector<std::string>& names) {
+            Expressions expressions;
+            exprs.clear();
+            for (const auto& name : names) exprs.push_back(expressions.insert(0, Relations(), Value::String(name)));
+            for (const auto& op : ops) exprs.push_back(expressions.insert(1, Relations(exprs[op.lhs], exprs[op.rhs])));
+            return static_cast<double>(expressions.pool.size());
+        });
+        measure("v2 move", num_values, num_distinct, ops, [&](std::vector<std::string>& names) {
+            Expressions expressions;
+            exprs.clear();
+            for (auto& name : names) exprs.push_back(expressions.insert(0, Relations(), Value::String(std::move(name))));
+            for (const auto& op : ops) exprs.push_back(expressions.insert(1, Relations(exprs[op.lhs], exprs[op.rhs])));
+            return static_cast<double>(expressions.pool.size());
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/arena_allocator.h>
+#include <do_ast/v1_ast.h>
+#include <do_ast/v2.h>
+#include <do_ast/nodes_postorder.h>
+#include <do_ast/type_value.h>
+
+// build and teardown of a reduction tree with the default allocator and with a bump arena.
+// with the arena the containers never free, teardown is the destructors plus one release of all chunks.
+
+struct Timing
+{
+    std::chrono::duration<double> build{0};
+    std::chrono::duration<double> teardown{0};
+};
+
+void print(const std::string& name, const Timing& timing, int num_it)
+{
+    std::cout << "  " << name << " build: " << (timing.build.count() / num_it) * 1000 << " ms"
+              << " teardown: " << (timing.teardown.count() / num_it) * 1000 << " ms\n";
+}
+
+// MakeAllocator returns the allocator for the containers, Release is called after they are destroyed
+template<class TAllocator, class MakeAllocator, class Release>
+void run(const std::string& name, uint32_t num_values, const std::vector<Operation>& ops, int num_it, MakeAllocator make_allocator, Release release)
+{
+    using namespace do_ast;
+    using Policy = ItemPoolPolicy<VectorStorage_<TAllocator>>;
+    using Ast = v1::Ast_<Policy>;
+    using Relations = v2::Relations_<ItemPoolIndex, 4>;
+    using Expressions = v2::Expressions<uint32_t, Relations, v2::ValueUnion<sizeof(double)>, Policy>;
+    using Value = typename Expressions::Value;
+    using Node = TypeValue<uint32_t, double>;
+    using Nodes = NodesPostorder<Node, uint32_t, uint32_t, uint32_t, rebind_alloc_t<TAllocator, Node>>;
+
+    Timing t_v1, t_v2, t_v3;
+    double sum = 0;
+    std::vector<ItemPoolIndex> exprs;
+    std::vector<uint32_t> ids;
+    exprs.reserve(num_values + ops.size());
+    ids.reserve(num_values + ops.size());
+
+    auto t_start = std::chrono::system_clock::now();
+    auto t_end = t_start;
+    for (int it = 0; it < num_it; ++it)
+    {
+        {
+            t_start = std::chrono::system_clock::now();
+            Ast ast(make_allocator());
+            exprs.clear();
+            for (uint32_t i = 0; i < num_values; ++i) exprs.push_back(ast.create_with_value(0, static_cast<double>(i)));
+            for (const auto& op : ops) exprs.push_back(ast.create_with_args(1, exprs[op.lhs], exprs[op.rhs]));
+            sum += exprs.back().index;
+            t_end = std::chrono::system_clock::now();
+            t_v1.build += t_end - t_start;
+        }
+        release();
+        t_start = std::chrono::system_clock::now();
+        t_v1.teardown += t_start - t_end;
+        {
+            Expressions expressions(make_allocator());
+            exprs.clear();
+            for (uint32_t i = 0; i < num_values; ++i) exprs.push_back(expressions.insert(0, Relations(), Value::Double(i)));
+            for (const auto& op : ops) exprs.push_back(expressions.insert(1, Relations(exprs[op.lhs], exprs[op.rhs])));
+            sum += expressions.pool.size();
+            t_end = std::chrono::system_clock::now();
+            t_v2.build += t_end - t_start;
+        }
+        release();
+        t_start = std::chrono::system_clock::now();
+        t_v2.teardown += t_start - t_end;
+        {
+            Nodes nodes(make_allocator());
+            ids.clear();
+            for (uint32_t i = 0; i < num_values; ++i) ids.push_back(nodes.add_node(Node{0, static_cast<double>(i)}));
+            for (const auto& op : ops) ids.push_back(nodes.add_node(Node{1, 0}, ids[op.lhs], ids[op.rhs]));
+            sum += ids.back();
+            t_end = std::chrono::system_clock::now();
+            t_v3.build += t_end - t_start;
+        }
+        release();
+        t_start = std::chrono::system_clock::now();
+        t_v3.teardown += t_start - t_end;
+    }
+
+    std::cout << name << "\n";
+    print("v1::Ast        ", t_v1, num_it);
+    print("v2::Expressions", t_v2, num_it);
+    print("NodesPostorder ", t_v3, num_it);
+    std::cout << "  sum " << sum << "\n";
+}
+
+int main()
+{
+    using namespace do_ast;
+
+    std::vector<Operation> ops;
+    uint32_t num_values = 512*1024;
+    mk_reduction(num_values, ops);
+    int num_it = 8;
+
+    std::cout << "leaves " << num_values << " nodes " << (num_values + ops.size()) << "\n";
+
+    run<std::allocator<char>>("std::allocator", num_values, ops, num_it,
+        []() { return std::allocator<char>(); },
+        []() {}
+    );
+
+    MonotonicArena arena;
+    run<ArenaAllocator<char>>("ArenaAllocator", num_values, ops, num_it,
+        [&arena]() { return ArenaAllocator<char>(arena); },
+        [&arena]() { arena.release(); }
+    );
+    return 0;
+}
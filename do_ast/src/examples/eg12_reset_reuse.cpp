@@ -0,0 +1,136 @@
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <new>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v1_ast.h>
+#include <do_ast/v2.h>
+
+// rebuilds a tree once per simulated request, like a server reusing one ast per request.
+// compares a new ast per request, clear() and reset() between requests.
+// reset() is O(1) and keeps the constructed slots, the steady state rebuild allocates nothing.
+
+static uint64_t num_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++num_allocations;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+template<class Rebuild>
+void measure(const std::string& name, int num_requests, Rebuild rebuild)
+{
+    // the first request warms up the containers
+    double checksum = rebuild();
+    auto allocations_before = num_allocations;
+    auto t0 = std::chrono::system_clock::now();
+    for (int k = 1; k < num_requests; ++k)
+    {
+        checksum += rebuild();
+    }
+    auto t1 = std::chrono::system_clock::now();
+    auto allocations = num_allocations - allocations_before;
+
+    std::chrono::duration<double> d = t1-t0;
+    std::cout << name << "\n";
+    std::cout << "  time/request:        " << (d.count() / (num_requests - 1)) * 1000 << " ms\n";
+    std::cout << "  allocations/request: " << static_cast<double>(allocations) / (num_requests - 1) << "\n";
+    std::cout << "  checksum " << checksum << "\n";
+}
+
+int main()
+{
+    using namespace do_ast;
+    using Ast = v1::Ast;
+    using Relations = v2::Relations_<ItemPoolIndex, 4>;
+    using Expressions = v2::Expressions<uint32_t, Relations, v2::ValueUnion<sizeof(double)>>;
+    using Value = typename Expressions::Value;
+
+    std::vector<Operation> ops;
+    uint32_t num_values = 64*1024;
+    mk_reduction(num_values, ops);
+    int num_requests = 64;
+
+    std::cout << "leaves " << num_values << " nodes " << (num_values + ops.size()) << " requests " << num_requests << "\n";
+
+    std::vector<ItemPoolIndex> exprs;
+    exprs.reserve(num_values + ops.size());
+
+    auto build_v1 = [&](Ast& ast) {
+        exprs.clear();
+        for (uint32_t i = 0; i < num_values; ++i) exprs.push_back(ast.create_with_value(0, static_cast<double>(i)));
+        for (const auto& op : ops) exprs.push_back(ast.create_with_args(1, exprs[op.lhs], exprs[op.rhs]));
+        return static_cast<double>(exprs.back().index);
+    };
+    auto build_v2 = [&](Expressions& expressions) {
+        exprs.clear();
+        for (uint32_t i = 0; i < num_values; ++i) exprs.push_back(expressions.insert(0, Relations(), Value::Double(i)));
+        for (const auto& op : ops) exprs.push_back(expressions.insert(1, Relations(exprs[op.lhs], exprs[op.rhs])));
+        return static_cast<double>(expressions.pool.size());
+    };
+
+    measure("v1 new ast", num_requests, [&]() {
+        Ast ast;
+        return build_v1(ast);
+    });
+    {
+        Ast ast;
+        measure("v1 clear", num_requests, [&]() {
+            ast.clear();
+            return build_v1(ast);
+        });
+    }
+    {
+        Ast ast;
+        measure("v1 reset", num_requests, [&]() {
+            ast.reset();
+            return build_v1(ast);
+        });
+    }
+    measure("v2 new expressions", num_requests, [&]() {
+        Expressions expressions;
+        return build_v2(expressions);
+    });
+    {
+        Expressions expressions;
+        measure("v2 clear", num_requests, [&]() {
+            expressions.pool.clear();
+            return build_v2(expressions);
+        });
+    }
+    {
+        Expressions expressions;
+        measure("v2 reset", num_requests, [&]() {
+            expressions.reset();
+            return build_v2(expressions);
+        });
+    }
+    {
+        // a handle from before the reset is stale, erasing it again changes nothing
+        Expressions expressions;
+        auto old = expressions.insert(0, Relations(), Value::Double(1));
+        expressions.reset();
+        expressions.erase(old);
+        auto fresh = expressions.insert(0, Relations(), Value::Double(2));
+        bool ok = (expressions.pool.size() == 1) && expressions.pool.contains(fresh) && !expressions.pool.contains(old);
+        std::cout << "erase after reset: " << (ok ? "ok" : "WRONG") << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "mk_reduction.h"
+#include <do_ast/v2.h>
+
+// traversal after a long rewrite loop with the LifoReuse and LowestIndexReuse free slot policies.
+// the loop rewrites random bottom subtrees and now and then allocates and frees a batch of scratch expressions.
+// with lifo the rewritten nodes land in the scattered scratch slots and the live set spreads over the columns.
+// lowest index refills the holes at the front and keeps the live set dense.
+
+template<class TReuse>
+void run(const std::string& name, uint32_t num_values, const std::vector<Operation>& ops, uint32_t num_cycles, int num_it)
+{
+    using namespace do_ast;
+    using Relations = v2::Relations_<ItemPoolIndex, 4>;
+    using Policy = ItemPoolPolicy<VectorStorage, ItemPoolIndex, TReuse>;
+    using Expressions = v2::Expressions<uint32_t, Relations, v2::ValueUnion<sizeof(double)>, Policy>;
+    using Value = typename Expressions::Value;
+    using Expression = typename Expressions::Expression;
+
+    struct Bottom
+    {
+        Expression op;
+        Expression lhs;
+        Expression rhs;
+        Expression parent;
+        uint32_t parent_arg;
+    };
+
+    Expressions expressions;
+    std::vector<Expression> exprs;
+    exprs.reserve(num_values + ops.size());
+    for (uint32_t i = 0; i < num_values; ++i) exprs.push_back(expressions.insert(0, Relations(), Value::Double(i)));
+    for (const auto& op : ops) exprs.push_back(expressions.insert(1, Relations(exprs[op.lhs], exprs[op.rhs])));
+    auto root = exprs.back();
+
+    // ops over two leaves, with the op referencing them
+    std::vector<Bottom> bottoms;
+    std::vector<uint32_t> bottom_of(exprs.size(), UINT32_MAX);
+    for (uint32_t k = 0; k < ops.size(); ++k)
+    {
+        const auto& op = ops[k];
+        if ((op.lhs < num_values) && (op.rhs < num_values))
+        {
+            bottom_of[num_values + k] = static_cast<uint32_t>(bottoms.size());
+            bottoms.push_back(Bottom{exprs[num_values + k], exprs[op.lhs], exprs[op.rhs], Expression(), 0});
+        }
+    }
+    for (uint32_t k = 0; k < ops.size(); ++k)
+    {
+        const auto& op = ops[k];
+        if (bottom_of[op.lhs] != UINT32_MAX) { bottoms[bottom_of[op.lhs]].parent = exprs[num_values + k]; bottoms[bottom_of[op.lhs]].parent_arg = 0; }
+        if (bottom_of[op.rhs] != UINT32_MAX) { bottoms[bottom_of[op.rhs]].parent = exprs[num_values + k]; bottoms[bottom_of[op.rhs]].parent_arg = 1; }
+    }
+
+    // one cycle is one erase and one insert, a rewrite is three cycles
+    std::mt19937 rng(42);
+    std::vector<Expression> scratch;
+    uint32_t scratch_every = 64*1024;
+    uint32_t scratch_size = num_values / 2;
+    auto t0 = std::chrono::system_clock::now();
+    for (uint32_t cycle = 0; cycle < num_cycles; cycle += 3)
+    {
+        if (cycle % scratch_every < 3)
+        {
+            scratch.clear();
+            for (uint32_t i = 0; i < scratch_size; ++i) scratch.push_back(expressions.insert(2));
+            std::shuffle(scratch.begin(), scratch.end(), rng);
+            for (auto expr : scratch) expressions.pool.erase(expr);
+        }
+        auto& bottom = bottoms[rng() % bottoms.size()];
+        auto value = static_cast<double>(cycle % 1024);
+        auto lhs = expressions.insert(0, Relations(), Value::Double(value));
+        auto rhs = expressions.insert(0, Relations(), Value::Double(value + 1));
+        auto op = expressions.insert(1, Relations(lhs, rhs));
+        if (bottom.parent.smc != 0)
+        {
+            expressions.pool.template get<1>(bottom.parent).args[bottom.parent_arg] = op;
+        }
+        else
+        {
+            root = op;
+        }
+        expressions.pool.erase(bottom.op);
+        expressions.pool.erase(bottom.lhs);
+        expressions.pool.erase(bottom.rhs);
+        bottom.op = op;
+        bottom.lhs = lhs;
+        bottom.rhs = rhs;
+    }
+    auto t1 = std::chrono::system_clock::now();
+
+    double sum = 0;
+    typename Expressions::TraversalContext ctx;
+    for (int it = 0; it < num_it; ++it)
+    {
+        expressions.traverse_post_order(root, [&sum](int depth, Expression expr, uint32_t type, const Relations& rel, const Value& value)
+        {
+            if (type == 0) sum += value.as_double[0];
+        }, ctx);
+    }
+    auto t2 = std::chrono::system_clock::now();
+
+    std::size_t span = 0;
+    expressions.pool.for_each_live([&span](Expression expr) { span = expr.index + 1; });
+
+    std::chrono::duration<double> d_churn = t1-t0;
+    std::chrono::duration<double> d_traverse = t2-t1;
+    std::cout << name << "\n";
+    std::cout << "  churn:    " << d_churn.count() * 1000 << " ms\n";
+    std::cout << "  traverse: " << (d_traverse.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  live " << expressions.pool.size() << " span " << span << "\n";
+    std::cout << "  sum " << sum << "\n";
+}
+
+int main()
+{
+    using namespace do_ast;
+
+    std::vector<Operation> ops;
+    uint32_t num_values = 256*1024;
+    mk_reduction(num_values, ops);
+    uint32_t num_cycles = 1000*1000;
+    int num_it = 16;
+
+    std::cout << "leaves " << num_values << " nodes " << (num_values + ops.size()) << " cycles " << num_cycles << "\n";
+
+    run<LifoReuse>("LifoReuse", num_values, ops, num_cycles, num_it);
+    run<LowestIndexReuse>("LowestIndexReuse", num_values, ops, num_cycles, num_it);
+    return 0;
+}
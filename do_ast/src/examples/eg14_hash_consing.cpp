@@ -0,0 +1,130 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v1.h>
+
+// builds a reduction over repeating leaf values with and without interning.
+// with interning equal subtrees are created once and shared, the tree becomes a dag.
+// a walker that skips already evaluated expressions then evaluates each shared subtree once.
+
+using namespace do_ast;
+using Ast = v1::Ast;
+using Walker = v1::Walker;
+using WalkAction = v1::WalkAction;
+using ArgRange = Ast::ArgRange;
+
+enum ExprType : uint32_t { Value = 0, Add = 1 };
+
+ItemPoolIndex build(Ast& ast, uint32_t num_values, uint32_t period, const std::vector<Operation>& ops, std::vector<ItemPoolIndex>& exprs)
+{
+    exprs.clear();
+    for (uint32_t i = 0; i < num_values; ++i) exprs.push_back(ast.create_with_value(Value, static_cast<double>(i % period)));
+    for (const auto& op : ops) exprs.push_back(ast.create_with_args(Add, exprs[op.lhs], exprs[op.rhs]));
+    return exprs.back();
+}
+
+double evaluate(const Ast& ast, Walker& walker, std::vector<double>& stack, ItemPoolIndex root)
+{
+    // every expression is evaluated once per path to it
+    stack.clear();
+    walker.walk_post_order(ast, root, [&](ItemPoolIndex expr_idx, const Ast::Expression& expr, ArgRange args)
+    {
+        if (args.empty())
+        {
+            stack.push_back(*ast.value<double>(expr));
+            return WalkAction::Continue;
+        }
+        auto rhs = stack.back();
+        stack.pop_back();
+        stack.back() += rhs;
+        return WalkAction::Continue;
+    });
+    return stack.back();
+}
+
+double evaluate_memoized(const Ast& ast, Walker& walker, std::vector<double>& results, std::vector<uint8_t>& done, ItemPoolIndex root)
+{
+    // every expression is evaluated once, shared ones are not walked again
+    done.assign(results.size(), 0);
+    auto pre = [&](ItemPoolIndex expr_idx, const Ast::Expression& expr, ArgRange args)
+    {
+        return done[expr_idx.index] ? WalkAction::SkipChildren : WalkAction::Continue;
+    };
+    auto post = [&](ItemPoolIndex expr_idx, const Ast::Expression& expr, ArgRange args)
+    {
+        if (done[expr_idx.index]) return WalkAction::Continue;
+        results[expr_idx.index] = args.empty() ? *ast.value<double>(expr) : results[args[0].index] + results[args[1].index];
+        done[expr_idx.index] = 1;
+        return WalkAction::Continue;
+    };
+    walker.walk(ast, root, pre, v1::NoWalkCallback(), post);
+    return results[root.index];
+}
+
+int main()
+{
+    std::vector<Operation> ops;
+    uint32_t num_values = 1024*1024;
+    uint32_t period = 64;
+    mk_reduction(num_values, ops);
+    int num_it = 16;
+
+    std::cout << "leaves " << num_values << " nodes " << (num_values + ops.size()) << " distinct leaf values " << period << "\n";
+
+    std::vector<ItemPoolIndex> exprs;
+    exprs.reserve(num_values + ops.size());
+    Walker walker;
+    std::vector<double> stack;
+
+    Ast tree;
+    auto t0 = std::chrono::system_clock::now();
+    auto tree_root = build(tree, num_values, period, ops, exprs);
+    auto t1 = std::chrono::system_clock::now();
+
+    Ast dag;
+    dag.set_interning(true);
+    auto t2 = std::chrono::system_clock::now();
+    auto dag_root = build(dag, num_values, period, ops, exprs);
+    auto t3 = std::chrono::system_clock::now();
+
+    std::chrono::duration<double> d_tree = t1-t0;
+    std::chrono::duration<double> d_dag = t3-t2;
+    std::cout << "build tree:     " << d_tree.count() * 1000 << " ms, " << tree.size() << " expressions\n";
+    std::cout << "build interned: " << d_dag.count() * 1000 << " ms, " << dag.size() << " expressions\n";
+    std::cout << "  root references " << dag.ref_count(dag_root) << ", leaf 0 references " << dag.ref_count(exprs[0]) << "\n";
+
+    double sum = 0;
+    t0 = std::chrono::system_clock::now();
+    for (int it = 0; it < num_it; ++it) sum += evaluate(tree, walker, stack, tree_root);
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d_eval_tree = t1-t0;
+    std::cout << "evaluate tree:             " << (d_eval_tree.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  sum " << sum << "\n";
+
+    sum = 0;
+    t0 = std::chrono::system_clock::now();
+    for (int it = 0; it < num_it; ++it) sum += evaluate(dag, walker, stack, dag_root);
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d_eval_dag = t1-t0;
+    std::cout << "evaluate interned:         " << (d_eval_dag.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  sum " << sum << "\n";
+
+    std::vector<double> results(num_values + ops.size());
+    std::vector<uint8_t> done;
+    sum = 0;
+    t0 = std::chrono::system_clock::now();
+    for (int it = 0; it < num_it; ++it) sum += evaluate_memoized(dag, walker, results, done, dag_root);
+    t1 = std::chrono::system_clock::now();
+    std::chrono::duration<double> d_eval_memo = t1-t0;
+    std::cout << "evaluate interned, shared: " << (d_eval_memo.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  sum " << sum << "\n";
+
+    // the root holds the only reference to the dag, erasing it releases every shared expression
+    dag.erase_expr_recursive(dag_root);
+    std::cout << "after erasing the interned root: " << dag.size() << " expressions\n";
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "mk_reduction.h"
+#include <do_ast/v1.h>
+
+// a long running session that keeps updating one leaf of a reduction at a time.
+// every update copies the path from the leaf to the root, the new root shares all other subtrees with the old one.
+// the old path can not be freed with erase_expr_recursive, its children are shared, so the pool grows until
+// a collection frees what the current root no longer reaches.
+// the full collection stops the session for the whole collection, the incremental one runs in small steps
+// between updates.
+
+using namespace do_ast;
+using Ast = v1::Ast;
+using Clock = std::chrono::system_clock;
+
+enum ExprType : uint32_t { Value = 0, Add = 1 };
+
+struct Session
+{
+    Ast ast;
+    uint32_t num_values;
+    std::vector<Operation> ops;
+    std::vector<uint32_t> parent;
+    // current expression of every position of the reduction
+    std::vector<ItemPoolIndex> exprs;
+    std::mt19937 rng{42};
+    double checksum = 0;
+
+    Session(uint32_t num_values) : num_values(num_values)
+    {
+        mk_reduction(num_values, ops);
+        parent.assign(num_values + ops.size(), UINT32_MAX);
+        for (uint32_t k = 0; k < ops.size(); ++k)
+        {
+            parent[ops[k].lhs] = num_values + k;
+            parent[ops[k].rhs] = num_values + k;
+        }
+        for (uint32_t i = 0; i < num_values; ++i) exprs.push_back(ast.create_with_value(Value, 1.0));
+        for (const auto& op : ops) exprs.push_back(ast.create_with_args(Add, exprs[op.lhs], exprs[op.rhs]));
+        checksum = num_values;
+    }
+
+    ItemPoolIndex root() const { return exprs.back(); }
+
+    void update()
+    {
+        auto leaf = rng() % num_values;
+        auto value = static_cast<double>(rng() % 8);
+        checksum += value - *ast.value<double>(exprs[leaf]);
+        exprs[leaf] = ast.create_with_value(Value, value);
+        for (auto pos = parent[leaf]; pos != UINT32_MAX; pos = parent[pos])
+        {
+            const auto& op = ops[pos - num_values];
+            exprs[pos] = ast.create_with_args(Add, exprs[op.lhs], exprs[op.rhs]);
+        }
+    }
+
+    bool verify() const
+    {
+        auto sum = ast.fold<double>(root(),
+            [this](ItemPoolIndex, const Ast::Expression& expr) { return *ast.value<double>(expr); },
+            [](ItemPoolIndex, const Ast::Expression&, v1::ArgRange_<double> results) { return results[0] + results[1]; });
+        return sum == checksum;
+    }
+};
+
+int main()
+{
+    uint32_t num_values = 256*1024;
+    int num_rounds = 8;
+    int num_updates = 16*1024;
+    std::size_t budget = 4096;
+
+    {
+        Session session(num_values);
+        std::cout << "full collection\n";
+        std::cout << "  live " << session.ast.size() << "\n";
+        double max_pause = 0;
+        for (int round = 0; round < num_rounds; ++round)
+        {
+            for (int k = 0; k < num_updates; ++k) session.update();
+            auto size_before = session.ast.size();
+            auto root = session.root();
+            auto t0 = Clock::now();
+            auto num_freed = session.ast.collect(&root, 1);
+            auto t1 = Clock::now();
+            std::chrono::duration<double> d = t1-t0;
+            max_pause = std::max(max_pause, d.count());
+            std::cout << "  round " << round << ": " << size_before << " -> " << session.ast.size() << " expressions, freed " << num_freed << " in " << d.count() * 1000 << " ms\n";
+        }
+        std::cout << "  longest pause " << max_pause * 1000 << " ms, " << (session.verify() ? "sum ok" : "SUM WRONG") << "\n";
+    }
+
+    {
+        Session session(num_values);
+        // a collection begins once the pool grew by 60% over what the last one left, about as much garbage
+        // as the full collection finds, then it runs one step per update
+        std::cout << "incremental collection, budget " << budget << " per step, one step per update\n";
+        auto trigger = session.ast.size() * 8 / 5;
+        int num_collections = 0;
+        double max_pause = 0;
+        double total = 0;
+        std::size_t num_steps = 0;
+        for (int round = 0; round < num_rounds; ++round)
+        {
+            auto size_before = session.ast.size();
+            for (int k = 0; k < num_updates; ++k)
+            {
+                session.update();
+                if (!session.ast.is_collecting())
+                {
+                    if (session.ast.size() < trigger) continue;
+                    auto root = session.root();
+                    session.ast.begin_collection(&root, 1);
+                }
+                auto t0 = Clock::now();
+                if (session.ast.collect_step(budget))
+                {
+                    trigger = session.ast.size() * 8 / 5;
+                    ++num_collections;
+                }
+                auto t1 = Clock::now();
+                std::chrono::duration<double> d = t1-t0;
+                max_pause = std::max(max_pause, d.count());
+                total += d.count();
+                ++num_steps;
+            }
+            std::cout << "  round " << round << ": " << size_before << " -> " << session.ast.size() << " expressions, " << num_collections << " collections done\n";
+        }
+        std::cout << "  " << num_steps << " steps, " << total * 1000 << " ms in total, longest pause " << max_pause * 1000 << " ms, " << (session.verify() ? "sum ok" : "SUM WRONG") << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v1.h>
+
+// copies a template tree into a per request ast.
+// the per node copy creates one expression at a time through the public create functions,
+// clone_subtree sizes the pools in a counting pass and fills one block of slots.
+// a memcpy of the same number of expression and argument bytes is the lower bound.
+
+using namespace do_ast;
+using Ast = v1::Ast;
+using Clock = std::chrono::system_clock;
+
+enum ExprType : uint32_t { Value = 0, Name = 1, Add = 2 };
+
+template<class Copy>
+void measure(const std::string& name, int num_it, Copy copy)
+{
+    double checksum = 0;
+    auto t0 = Clock::now();
+    for (int it = 0; it < num_it; ++it) checksum += copy();
+    auto t1 = Clock::now();
+    std::chrono::duration<double> d = t1-t0;
+    std::cout << name << ": " << (d.count() / num_it) * 1000 << " ms\n";
+    std::cout << "  checksum " << checksum << "\n";
+}
+
+int main()
+{
+    std::vector<Operation> ops;
+    uint32_t num_values = 256*1024;
+    mk_reduction(num_values, ops);
+    int num_it = 32;
+
+    // every 16th leaf is an identifier
+    Ast src;
+    std::vector<ItemPoolIndex> exprs;
+    for (uint32_t i = 0; i < num_values; ++i)
+    {
+        exprs.push_back((i % 16 == 0) ? src.create_with_value(Name, "identifier_" + std::to_string(i % 256)) : src.create_with_value(Value, static_cast<double>(i)));
+    }
+    for (const auto& op : ops) exprs.push_back(src.create_with_args(Add, exprs[op.lhs], exprs[op.rhs]));
+    auto root = exprs.back();
+
+    std::cout << "nodes " << src.size() << "\n";
+
+    Ast dst;
+    Ast::FoldContext<ItemPoolIndex> ctx;
+    measure("per node copy", num_it, [&]() {
+        dst.reset();
+        auto copy = src.fold<ItemPoolIndex>(root,
+            [&](ItemPoolIndex, const Ast::Expression& expr) {
+                return (expr.expr_type == Name) ? dst.create_with_value(Name, src.string_value(expr)) : dst.create_with_value(Value, *src.value<double>(expr));
+            },
+            [&](ItemPoolIndex, const Ast::Expression& expr, v1::ArgRange_<ItemPoolIndex> results) {
+                return dst.create_with_args(expr.expr_type, results[0], results[1]);
+            }, ctx);
+        return static_cast<double>(dst.size() + copy.index);
+    });
+    measure("clone_subtree", num_it, [&]() {
+        dst.reset();
+        auto copy = v1::clone_subtree(src, root, dst);
+        return static_cast<double>(dst.size() + copy.index);
+    });
+
+    std::vector<char> bytes_src(src.size() * sizeof(Ast::Expression) + ops.size() * sizeof(Ast::ArgExpressionList<2>), 1);
+    std::vector<char> bytes_dst(bytes_src.size());
+    measure("memcpy of the expressions and argument lists", num_it, [&]() {
+        std::memcpy(bytes_dst.data(), bytes_src.data(), bytes_src.size());
+        return static_cast<double>(bytes_dst[bytes_dst.size() / 2]);
+    });
+
+    // the copy evaluates like the template
+    auto evaluate = [](const Ast& ast, ItemPoolIndex root) {
+        return ast.fold<double>(root,
+            [&](ItemPoolIndex, const Ast::Expression& expr) { return (expr.expr_type == Name) ? 0.0 : *ast.value<double>(expr); },
+            [](ItemPoolIndex, const Ast::Expression&, v1::ArgRange_<double> results) { return results[0] + results[1]; });
+    };
+    dst.reset();
+    auto copy = v1::clone_subtree(src, root, dst);
+    std::cout << "sum template " << evaluate(src, root) << " copy " << evaluate(dst, copy) << ", strings " << dst.strings().size() << "\n";
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v1.h>
+
+// saves a reduction to a file and loads it back.
+// load reads each column with one read and fills every pool in one pass, it is compared with reading
+// the file bytes alone and with creating the same expressions one by one through the public create functions.
+
+using namespace do_ast;
+using Ast = v1::Ast;
+using Clock = std::chrono::system_clock;
+
+enum ExprType : uint32_t { Value = 0, Name = 1, Add = 2 };
+
+double seconds_since(Clock::time_point t0)
+{
+    std::chrono::duration<double> d = Clock::now() - t0;
+    return d.count();
+}
+
+double evaluate(const Ast& ast, ItemPoolIndex root)
+{
+    return ast.fold<double>(root,
+        [&](ItemPoolIndex, const Ast::Expression& expr) { return (expr.expr_type == Name) ? static_cast<double>(ast.string_value(expr).size()) : *ast.value<double>(expr); },
+        [](ItemPoolIndex, const Ast::Expression&, v1::ArgRange_<double> results) { return results[0] + results[1]; });
+}
+
+int main()
+{
+    std::vector<Operation> ops;
+    uint32_t num_values = 2*1024*1024;
+    mk_reduction(num_values, ops);
+    const char* path = "eg17_serialization.bin";
+
+    // every 16th leaf is an identifier
+    Ast src;
+    std::vector<ItemPoolIndex> exprs;
+    std::vector<ItemPoolIndex> garbage;
+    for (uint32_t i = 0; i < num_values; ++i)
+    {
+        exprs.push_back((i % 16 == 0) ? src.create_with_value(Name, "identifier_" + std::to_string(i % 256)) : src.create_with_value(Value, static_cast<double>(i)));
+        if (i % 4 == 0) garbage.push_back(src.create_with_value(Value, 0.0));
+    }
+    for (const auto& op : ops) exprs.push_back(src.create_with_args(Add, exprs[op.lhs], exprs[op.rhs]));
+    auto root = exprs.back();
+    // free slots between the live expressions, the file numbers the expressions densely
+    for (auto expr_idx : garbage) src.erase_expr(expr_idx);
+    std::cout << "nodes " << src.size() << "\n";
+
+    auto t0 = Clock::now();
+    {
+        std::ofstream os(path, std::ios::binary);
+        src.save(os, &root, 1);
+    }
+    auto d_save = seconds_since(t0);
+
+    t0 = Clock::now();
+    std::vector<char> bytes;
+    {
+        std::ifstream is(path, std::ios::binary | std::ios::ate);
+        bytes.resize(static_cast<std::size_t>(is.tellg()));
+        is.seekg(0);
+        is.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    auto d_read = seconds_since(t0);
+
+    Ast dst;
+    std::vector<ItemPoolIndex> roots;
+    t0 = Clock::now();
+    bool ok;
+    {
+        std::ifstream is(path, std::ios::binary);
+        ok = dst.load(is, roots);
+    }
+    auto d_load = seconds_since(t0);
+
+    // a reset ast keeps its pools and the load scratch, the second load does not allocate
+    dst.reset();
+    t0 = Clock::now();
+    {
+        std::ifstream is(path, std::ios::binary);
+        ok = ok && dst.load(is, roots);
+    }
+    auto d_reload = seconds_since(t0);
+
+    // the same expressions created one at a time, without any file
+    Ast copy;
+    t0 = Clock::now();
+    auto copy_root = src.fold<ItemPoolIndex>(root,
+        [&](ItemPoolIndex, const Ast::Expression& expr) {
+            return (expr.expr_type == Name) ? copy.create_with_value(Name, src.string_value(expr)) : copy.create_with_value(Value, *src.value<double>(expr));
+        },
+        [&](ItemPoolIndex, const Ast::Expression& expr, v1::ArgRange_<ItemPoolIndex> results) {
+            return copy.create_with_args(expr.expr_type, results[0], results[1]);
+        });
+    auto d_create = seconds_since(t0);
+
+    std::cout << "file " << bytes.size() / (1024*1024) << " MiB\n";
+    std::cout << "save:                " << d_save * 1000 << " ms\n";
+    std::cout << "read the file bytes: " << d_read * 1000 << " ms\n";
+    std::cout << "load:                " << d_load * 1000 << " ms, " << (ok ? "ok" : "FAILED") << ", " << dst.size() << " expressions\n";
+    std::cout << "load after reset:    " << d_reload * 1000 << " ms\n";
+    std::cout << "create one by one:   " << d_create * 1000 << " ms, " << copy.size() << " expressions\n";
+    std::cout << "sum " << evaluate(src, root) << " loaded " << (ok ? evaluate(dst, roots[0]) : 0.0) << " created " << evaluate(copy, copy_root) << "\n";
+
+    // a truncated file is rejected
+    Ast broken;
+    std::ifstream is(path, std::ios::binary);
+    std::vector<char> head(bytes.size() / 2);
+    is.read(head.data(), static_cast<std::streamsize>(head.size()));
+    std::istringstream truncated(std::string(head.data(), head.size()));
+    std::cout << "truncated stream " << (broken.load(truncated, roots) ? "loaded" : "rejected") << ", " << broken.size() << " expressions\n";
+
+    std::remove(path);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v2.h>
+
+// evaluates one shared v2::Expressions pool from 1..N threads at the same time.
+// the pool is only read, every thread passes its own TraversalContext to traverse_post_order.
+// a context reused between traversals allocates once, the overload without context allocates per call.
+//   do_ast_eg18_v2_parallel_traversal [max_threads]
+
+using namespace do_ast;
+using Expressions = v2::Expressions<>;
+using Expression = typename Expressions::Expression;
+using Relations = typename Expressions::Relations;
+using Value = typename Expressions::Value;
+using TraversalContext = typename Expressions::TraversalContext;
+using Clock = std::chrono::system_clock;
+
+double evaluate(const Expressions& exprs, Expression root, TraversalContext& ctx, std::vector<double>& stack)
+{
+    stack.clear();
+    exprs.traverse_post_order(root, [&stack](int depth, Expression expr, uint32_t type, const Relations& rel, const Value& val)
+    {
+        if (type == 0)
+        {
+            stack.push_back(val.as_double[0]);
+            return;
+        }
+        auto rhs = stack.back();
+        stack.pop_back();
+        stack.back() += rhs;
+    }, ctx);
+    return stack.back();
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t max_threads = (argc > 1) ? static_cast<uint32_t>(std::stoul(argv[1])) : std::thread::hardware_concurrency();
+    if (max_threads == 0) max_threads = 4;
+    uint32_t num_values = 256*1024;
+    uint32_t total_evaluations = 64;
+
+    std::vector<Operation> ops;
+    mk_reduction(num_values, ops);
+    Expressions exprs;
+    std::vector<Expression> handles;
+    for (uint32_t i = 0; i < num_values; ++i) handles.push_back(exprs.insert(0, Relations(), Value::Double(i)));
+    for (const auto& op : ops) handles.push_back(exprs.insert(1, Relations(handles[op.lhs], handles[op.rhs])));
+    auto root = handles.back();
+    double expected = static_cast<double>(num_values) * (num_values - 1) / 2;
+    std::cout << "nodes " << handles.size() << ", " << total_evaluations << " evaluations per run\n";
+
+    {
+        // one thread: reused context against a context per call
+        TraversalContext ctx;
+        std::vector<double> stack;
+        double sum = 0;
+        auto t0 = Clock::now();
+        for (uint32_t it = 0; it < total_evaluations; ++it) sum += evaluate(exprs, root, ctx, stack);
+        auto t1 = Clock::now();
+        for (uint32_t it = 0; it < total_evaluations; ++it)
+        {
+            TraversalContext fresh;
+            sum += evaluate(exprs, root, fresh, stack);
+        }
+        auto t2 = Clock::now();
+        std::chrono::duration<double> d_reused = t1-t0;
+        std::chrono::duration<double> d_fresh = t2-t1;
+        std::cout << "reused context:   " << (d_reused.count() / total_evaluations) * 1000 << " ms per evaluation\n";
+        std::cout << "context per call: " << (d_fresh.count() / total_evaluations) * 1000 << " ms per evaluation\n";
+        std::cout << "  " << ((sum == 2 * total_evaluations * expected) ? "sum ok" : "SUM WRONG") << "\n";
+    }
+
+    for (uint32_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        std::vector<uint32_t> num_wrong(num_threads, 0);
+        std::vector<std::thread> threads;
+        auto t0 = Clock::now();
+        for (uint32_t t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                TraversalContext ctx;
+                std::vector<double> stack;
+                for (uint32_t it = t; it < total_evaluations; it += num_threads)
+                {
+                    if (evaluate(exprs, root, ctx, stack) != expected) ++num_wrong[t];
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        auto t1 = Clock::now();
+        uint32_t wrong = 0;
+        for (auto n : num_wrong) wrong += n;
+        std::chrono::duration<double> d = t1-t0;
+        std::cout << "threads " << num_threads << ": " << d.count() * 1000 << " ms, " << (wrong ? "SUMS WRONG" : "sums ok") << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v2.h>
+
+// lazy traversals of v2::Expressions: a search stops at its match, subtrees are skipped,
+// and in order traversals leave out disabled events at compile time.
+
+using namespace do_ast;
+using Expressions = v2::Expressions<>;
+using Expression = typename Expressions::Expression;
+using Relations = typename Expressions::Relations;
+using Value = typename Expressions::Value;
+using TraversalContext = typename Expressions::TraversalContext;
+using Clock = std::chrono::system_clock;
+
+enum ExprType : uint32_t { Number = 0, Add = 1, Needle = 2 };
+
+template<class Run>
+void measure(const std::string& name, int num_it, Run run)
+{
+    double checksum = 0;
+    auto t0 = Clock::now();
+    for (int it = 0; it < num_it; ++it) checksum += run();
+    auto t1 = Clock::now();
+    std::chrono::duration<double> d = t1-t0;
+    std::cout << name << ": " << (d.count() / num_it) * 1000 << " ms, checksum " << checksum << "\n";
+}
+
+int main()
+{
+    uint32_t num_values = 1024*1024;
+    int num_it = 16;
+    std::vector<Operation> ops;
+    mk_reduction(num_values, ops);
+
+    // one leaf in the first eighth of the tree is the needle
+    Expressions exprs;
+    std::vector<Expression> handles;
+    for (uint32_t i = 0; i < num_values; ++i) handles.push_back(exprs.insert((i == num_values / 8) ? Needle : Number, Relations(), Value::Double(i)));
+    for (const auto& op : ops) handles.push_back(exprs.insert(Add, Relations(handles[op.lhs], handles[op.rhs])));
+    auto root = handles.back();
+    std::cout << "nodes " << handles.size() << "\n";
+
+    TraversalContext ctx;
+
+    std::cout << "find the needle\n";
+    measure("  callback pre order", num_it, [&]() {
+        double found = -1;
+        exprs.traverse_pre_order(root, [&found](int depth, Expression expr, uint32_t type, const Relations& rel, const Value& val) {
+            if ((type == Needle) && (found < 0)) found = val.as_double[0];
+        }, ctx);
+        return found;
+    });
+    measure("  lazy pre order    ", num_it, [&]() {
+        for (const auto& item : exprs.pre_order(root, ctx))
+        {
+            if (*item.type == Needle) return item.value->as_double[0];
+        }
+        return -1.0;
+    });
+
+    std::cout << "sum of all leaves\n";
+    measure("  callback post order", num_it, [&]() {
+        double sum = 0;
+        exprs.traverse_post_order(root, [&sum](int depth, Expression expr, uint32_t type, const Relations& rel, const Value& val) {
+            if (rel.num_args == 0) sum += val.as_double[0];
+        }, ctx);
+        return sum;
+    });
+    measure("  lazy post order    ", num_it, [&]() {
+        double sum = 0;
+        for (const auto& item : exprs.post_order(root, ctx))
+        {
+            if (item.rel->num_args == 0) sum += item.value->as_double[0];
+        }
+        return sum;
+    });
+
+    std::cout << "leaves in order\n";
+    auto nothing = [](int, Expression, const uint32_t*, const Relations*, const Value*) {};
+    measure("  callback, runtime flags pre and post off", num_it, [&]() {
+        double sum = 0;
+        exprs.traverse_in_order(root, nothing, [&sum](int, Expression, const uint32_t* type, const Relations* rel, const Value* val) {
+            if (rel && (rel->num_args == 0)) sum += val->as_double[0];
+        }, nothing, ctx, false, true, false);
+        return sum;
+    });
+    measure("  lazy, all events                       ", num_it, [&]() {
+        double sum = 0;
+        for (const auto& item : exprs.in_order(root, ctx))
+        {
+            if ((item.event == v2::TraversalEvent::In) && item.rel && (item.rel->num_args == 0)) sum += item.value->as_double[0];
+        }
+        return sum;
+    });
+    measure("  lazy, In events only                   ", num_it, [&]() {
+        double sum = 0;
+        for (const auto& item : exprs.in_order<v2::InOrderEvents<false, true, false>>(root, ctx))
+        {
+            if (item.rel && (item.rel->num_args == 0)) sum += item.value->as_double[0];
+        }
+        return sum;
+    });
+
+    std::cout << "top of the tree\n";
+    measure("  lazy pre order, skip below depth 8", num_it, [&]() {
+        double count = 0;
+        auto traversal = exprs.pre_order(root, ctx);
+        for (const auto& item : traversal)
+        {
+            ++count;
+            if (item.depth == 8) traversal.skip_children();
+        }
+        return count;
+    });
+    return 0;
+}
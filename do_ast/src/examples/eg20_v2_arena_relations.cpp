@@ -0,0 +1,95 @@
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "mk_reduction.h"
+#include <do_ast/v2.h>
+
+// v2::Expressions with the relations in the column, Relations_<ItemPoolIndex,4>, and in a child arena,
+// ArenaRelations_. the column holds 80 bytes per expression also for the leaves, the arena entry 8 bytes,
+// the arguments follow in the arena. the same callbacks run on both, they read rel.args and rel.num_args.
+
+using namespace do_ast;
+using FixedExpressions = v2::Expressions<>;
+using ArenaExpressions = v2::Expressions<uint32_t, v2::ArenaRelations_<ItemPoolIndex>>;
+using Clock = std::chrono::system_clock;
+
+enum ExprType : uint32_t { Number = 0, Add = 1 };
+
+template<class Run>
+void measure(const std::string& name, int num_it, Run run)
+{
+    double checksum = 0;
+    auto t0 = Clock::now();
+    for (int it = 0; it < num_it; ++it) checksum += run();
+    auto t1 = Clock::now();
+    std::chrono::duration<double> d = t1-t0;
+    std::cout << name << ": " << (d.count() / num_it) * 1000 << " ms, checksum " << checksum << "\n";
+}
+
+template<class TExpressions>
+void run(const std::string& name, uint32_t num_values, const std::vector<Operation>& ops, int num_it)
+{
+    using Expression = typename TExpressions::Expression;
+    using Value = typename TExpressions::Value;
+
+    TExpressions exprs;
+    std::vector<Expression> handles;
+    for (uint32_t i = 0; i < num_values; ++i) handles.push_back(exprs.insert(Number, {}, Value::Double(i)));
+    for (const auto& op : ops)
+    {
+        Expression args[] = {handles[op.lhs], handles[op.rhs]};
+        handles.push_back(exprs.insert_with_args(Add, args, 2));
+    }
+    auto root = handles.back();
+
+    auto relations_bytes = column_bytes(exprs.pool.template slots<1>()) + exprs.child_arena().capacity() * sizeof(Expression);
+    std::cout << name << "\n";
+    std::cout << "  sizeof(Relations) " << sizeof(typename TExpressions::Relations) << ", relations " << relations_bytes << " bytes, all columns " << exprs.pool.columns_bytes() + exprs.child_arena().capacity() * sizeof(Expression) << " bytes\n";
+
+    typename TExpressions::TraversalContext ctx;
+    measure("  callback post order", num_it, [&]() {
+        double sum = 0;
+        exprs.traverse_post_order(root, [&sum](int depth, Expression expr, uint32_t type, const auto& rel, const Value& val) {
+            if (rel.num_args == 0) sum += val.as_double[0];
+        }, ctx);
+        return sum;
+    });
+    measure("  lazy pre order     ", num_it, [&]() {
+        double sum = 0;
+        for (const auto& item : exprs.pre_order(root, ctx))
+        {
+            if (item.rel->num_args == 0) sum += item.value->as_double[0];
+        }
+        return sum;
+    });
+}
+
+int main()
+{
+    uint32_t num_values = 1024*1024;
+    int num_it = 16;
+    std::vector<Operation> ops;
+    mk_reduction(num_values, ops);
+
+    run<FixedExpressions>("relations column", num_values, ops, num_it);
+    run<ArenaExpressions>("child arena", num_values, ops, num_it);
+
+    // the arena takes any number of arguments
+    {
+        using Expression = typename ArenaExpressions::Expression;
+        using Value = typename ArenaExpressions::Value;
+        ArenaExpressions exprs;
+        std::vector<Expression> args;
+        for (int i = 0; i < 16; ++i) args.push_back(exprs.insert(Number, {}, Value::Double(i)));
+        auto sum = exprs.insert_with_args(Add, args.data(), args.size());
+        double result = 0;
+        exprs.traverse_post_order(sum, [&result](int depth, Expression expr, uint32_t type, const auto& rel, const Value& val) {
+            if (type == Number) result += val.as_double[0];
+        });
+        std::cout << "sum of " << exprs.relations()[sum.index].num_args << " arguments = " << result << "\n";
+    }
+    return 0;
+}